@@ -0,0 +1,403 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        bitstream_bench.c
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file bitstream_bench.c
+ * @brief Equivalence check and speed of the bitstream kernels. Every
+ *        kernel built for the target (scalar, SSE2, AVX2, NEON) is run
+ *        over random sample buffers of every length up to MAX_WORDS and
+ *        compared with the scalar kernel, or with a plain per-lane loop
+ *        for the multi-lane counter and its min_width filter. Then each is timed in samples/s.
+ *        Exits non-zero on any mismatch.
+ *
+ * Only the kernels the compiler targets are built: configure with e.g.
+ * -DCMAKE_C_FLAGS=-mavx2 to include AVX2.
+ */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <time.h>
+
+#include "lmt01_bitstream.h"
+
+#define MAX_WORDS   200
+#define TRIALS      40
+#define SPEED_WORDS 4096
+#define ROUNDS      2000
+
+typedef uint32_t (*edges_fptr_t)(const uint32_t *buf, size_t words, uint32_t *carry);
+typedef uint32_t (*filtered_fptr_t)(const uint32_t *buf, size_t words, uint32_t min_width,
+                                    uint32_t *prev);
+
+static const struct
+{
+    const char *name;
+    edges_fptr_t fn;
+} edge_kernels[] = {
+    { "scalar", lmt_bitstream_count_edges_scalar },
+#if defined(__SSE2__)
+    { "SSE2",   lmt_bitstream_count_edges_sse2 },
+#endif
+#if defined(__AVX2__)
+    { "AVX2",   lmt_bitstream_count_edges_avx2 },
+#endif
+#if defined(__ARM_NEON)
+    { "NEON",   lmt_bitstream_count_edges_neon },
+#endif
+};
+
+static const struct
+{
+    const char *name;
+    filtered_fptr_t fn;
+} filtered_kernels[] = {
+    { "scalar", lmt_bitstream_count_edges_filtered_scalar },
+#if defined(__SSE2__)
+    { "SSE2",   lmt_bitstream_count_edges_filtered_sse2 },
+#endif
+};
+
+#define EDGE_KERNELS        (sizeof(edge_kernels) / sizeof(edge_kernels[0]))
+#define FILTERED_KERNELS    (sizeof(filtered_kernels) / sizeof(filtered_kernels[0]))
+
+static uint32_t buf[SPEED_WORDS];
+static volatile uint32_t sink;
+static uint32_t rng = 0x12345678u;
+
+static uint32_t rand32(void)
+{
+    /* xorshift32 */
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+
+    return rng;
+}
+
+/* Random words with runs of ones and zeros, so edges are neither rare
+   nor on every sample. density picks how often a bit is set. */
+static void fill(uint32_t *dst, size_t words, uint32_t density)
+{
+    size_t i;
+
+    for (i = 0; i < words; i++)
+    {
+        switch ((rand32() >> 8) % density)
+        {
+        case 0:
+            dst[i] = 0;
+            break;
+        case 1:
+            dst[i] = 0xffffffffu;
+            break;
+        default:
+            dst[i] = rand32() & rand32();
+            break;
+        }
+    }
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Every edge kernel against scalar, every length and carry in */
+static uint32_t check_edges(void)
+{
+    uint32_t failures = 0;
+    uint32_t k, t, carry, ref_carry, n, ref;
+    size_t words;
+
+    for (t = 0; t < TRIALS; t++)
+    {
+        fill(buf, MAX_WORDS, 3 + t % 4);
+
+        for (words = 0; words <= MAX_WORDS; words++)
+        {
+            for (k = 1; k < EDGE_KERNELS; k++)
+            {
+                ref_carry = carry = t & 1;
+                ref = lmt_bitstream_count_edges_scalar(buf, words, &ref_carry);
+                n = edge_kernels[k].fn(buf, words, &carry);
+
+                if (n != ref || carry != ref_carry)
+                {
+                    if (failures++ < 5)
+                        printf("  %s: %zu words gives %u edges, scalar %u\n",
+                               edge_kernels[k].name, words, n, ref);
+                }
+            }
+        }
+    }
+
+    printf("  %-18s %u mismatches\n", "count_edges", failures);
+
+    return failures;
+}
+
+/* Every filtered kernel against scalar, every width */
+static uint32_t check_filtered(void)
+{
+    uint32_t failures = 0;
+    uint32_t k, t, w, prev, ref_prev, n, ref;
+    size_t words;
+
+    for (t = 0; t < TRIALS; t++)
+    {
+        fill(buf, MAX_WORDS, 3 + t % 4);
+
+        for (w = 1; w <= 32; w++)
+        {
+            for (words = 0; words <= MAX_WORDS; words += 1 + words / 16)
+            {
+                for (k = 1; k < FILTERED_KERNELS; k++)
+                {
+                    ref_prev = prev = rand32();
+                    ref = lmt_bitstream_count_edges_filtered_scalar(buf, words, w, &ref_prev);
+                    n = filtered_kernels[k].fn(buf, words, w, &prev);
+
+                    if (n != ref || prev != ref_prev)
+                    {
+                        if (failures++ < 5)
+                            printf("  %s: %zu words, width %u gives %u pulses, scalar %u\n",
+                                   filtered_kernels[k].name, words, w, n, ref);
+                    }
+                }
+            }
+        }
+    }
+
+    printf("  %-18s %u mismatches\n", "count_edges_filt", failures);
+
+    return failures;
+}
+
+/* Multi-lane counter against one plain loop per lane, then the most
+   edges a lane can have: a rise every other sample */
+static uint32_t check_lanes(void)
+{
+    uint32_t failures = 0;
+    uint32_t counts[LMT_BITSTREAM_LANES];
+    uint32_t ref[LMT_BITSTREAM_LANES];
+    uint32_t t, lane, prev, active, ref_active, last;
+    size_t n, i;
+
+    for (t = 0; t < TRIALS; t++)
+    {
+        fill(buf, 3 * LMT_BITSTREAM_LANE_BLOCK, 3 + t % 4);
+
+        /* Longer than a block, and every length up to one */
+        for (n = 0; n <= 3 * LMT_BITSTREAM_LANE_BLOCK; n += (n < LMT_BITSTREAM_LANE_BLOCK) ? 1 : 61)
+        {
+            prev = rand32();
+            active = lmt_bitstream_lanes_count(buf, n, prev, counts);
+            ref_active = 0;
+
+            for (lane = 0; lane < LMT_BITSTREAM_LANES; lane++)
+            {
+                ref[lane] = 0;
+                last = (prev >> lane) & 1;
+
+                for (i = 0; i < n; i++)
+                {
+                    ref[lane] += ((buf[i] >> lane) & 1) & ~last;
+                    last = (buf[i] >> lane) & 1;
+                    ref_active |= last << lane;
+                }
+
+                if (counts[lane] != ref[lane])
+                {
+                    if (failures++ < 5)
+                        printf("  lanes: %zu samples, lane %u gives %u edges, reference %u\n",
+                               n, lane, counts[lane], ref[lane]);
+                }
+            }
+
+            if (active != ref_active)
+                failures++;
+        }
+    }
+
+    /* A lane rising on every other sample, over several blocks */
+    for (i = 0; i < 3 * LMT_BITSTREAM_LANE_BLOCK; i++)
+        buf[i] = (i & 1) ? 0 : 0xffffffffu;
+
+    lmt_bitstream_lanes_count(buf, 3 * LMT_BITSTREAM_LANE_BLOCK, 0, counts);
+
+    for (lane = 0; lane < LMT_BITSTREAM_LANES; lane++)
+    {
+        if (counts[lane] != 3 * LMT_BITSTREAM_LANE_BLOCK / 2)
+        {
+            if (failures++ < 5)
+                printf("  lanes: worst case, lane %u gives %u edges, reference %u\n",
+                       lane, counts[lane], 3 * LMT_BITSTREAM_LANE_BLOCK / 2);
+        }
+    }
+
+    printf("  %-18s %u mismatches\n", "lanes_count", failures);
+
+    return failures;
+}
+
+/* Multi-lane decoder with min_width against a run length per lane,
+   fed in uneven pieces so the filter history crosses calls */
+static uint32_t check_lanes_filtered(void)
+{
+    static uint32_t samples[4 * LMT_BITSTREAM_LANE_BLOCK];
+    uint32_t failures = 0;
+    uint32_t run[LMT_BITSTREAM_LANES];
+    uint32_t ref[LMT_BITSTREAM_LANES];
+    lmt_bitstream_lanes_t ml = {0};
+    uint32_t t, w, lane;
+    size_t n, i, piece;
+
+    n = sizeof(samples) / sizeof(samples[0]);
+
+    for (t = 0; t < TRIALS; t++)
+    {
+        /* Port samples with short and long runs on each lane */
+        for (i = 0; i < n; i++)
+            samples[i] = (i > 0 && (rand32() & 3) != 0) ? samples[i - 1] ^ (rand32() & rand32()) : rand32();
+
+        for (w = 2; w <= 32; w += 1 + w / 4)
+        {
+            ml.lane_mask = 0xffffffffu;
+            ml.min_width = w;
+            lmt_bitstream_lanes_reset(&ml);
+
+            for (i = 0; i < n; i += piece)
+            {
+                piece = 1 + rand32() % 300;
+                piece = (piece > n - i) ? n - i : piece;
+                lmt_bitstream_lanes_feed(&ml, samples + i, piece);
+            }
+
+            for (lane = 0; lane < LMT_BITSTREAM_LANES; lane++)
+            {
+                run[lane] = 0;
+                ref[lane] = 0;
+
+                for (i = 0; i < n; i++)
+                {
+                    run[lane] = ((samples[i] >> lane) & 1) ? run[lane] + 1 : 0;
+                    ref[lane] += (run[lane] == w);
+                }
+
+                if (ml.pulses[lane] != ref[lane])
+                {
+                    if (failures++ < 5)
+                        printf("  lanes: width %u, lane %u gives %u pulses, reference %u\n",
+                               w, lane, ml.pulses[lane], ref[lane]);
+                }
+            }
+        }
+    }
+
+    printf("  %-18s %u mismatches\n", "lanes_feed_filt", failures);
+
+    return failures;
+}
+
+int main(void)
+{
+    uint32_t failures = 0;
+    uint32_t counts[LMT_BITSTREAM_LANES];
+    uint32_t k, r, carry, acc;
+    double t0, rate;
+
+    printf("equivalence, up to %u words\n", MAX_WORDS);
+
+    failures += check_edges();
+    failures += check_filtered();
+    failures += check_lanes();
+    failures += check_lanes_filtered();
+
+    printf("\nspeed, Msamples/s\n");
+    fill(buf, SPEED_WORDS, 4);
+
+    for (k = 0; k < EDGE_KERNELS; k++)
+    {
+        acc = 0;
+        t0 = now_s();
+
+        for (r = 0; r < ROUNDS; r++)
+        {
+            carry = 0;
+            acc += edge_kernels[k].fn(buf, SPEED_WORDS, &carry);
+        }
+
+        rate = (double)ROUNDS * SPEED_WORDS * 32 / (now_s() - t0) / 1e6;
+        sink = acc;
+        printf("  %-18s %-6s %10.0f\n", "count_edges", edge_kernels[k].name, rate);
+    }
+
+    for (k = 0; k < FILTERED_KERNELS; k++)
+    {
+        acc = 0;
+        t0 = now_s();
+
+        for (r = 0; r < ROUNDS / 10; r++)
+        {
+            carry = 0;
+            acc += filtered_kernels[k].fn(buf, SPEED_WORDS, 4, &carry);
+        }
+
+        rate = (double)(ROUNDS / 10) * SPEED_WORDS * 32 / (now_s() - t0) / 1e6;
+        sink = acc;
+        printf("  %-18s %-6s %10.0f  (width 4)\n", "count_edges_filt", filtered_kernels[k].name, rate);
+    }
+
+    /* One port sample per word, all 32 lanes */
+    acc = 0;
+    t0 = now_s();
+
+    for (r = 0; r < ROUNDS; r++)
+    {
+        for (k = 0; k + LMT_BITSTREAM_LANE_BLOCK <= SPEED_WORDS; k += LMT_BITSTREAM_LANE_BLOCK)
+            acc += lmt_bitstream_lanes_count(buf + k, LMT_BITSTREAM_LANE_BLOCK, 0, counts);
+    }
+
+    rate = (double)ROUNDS * SPEED_WORDS / (now_s() - t0) / 1e6;
+    sink = acc;
+    printf("  %-18s %-6s %10.0f  (port samples, 32 lanes)\n", "lanes_count",
+#if defined(__SSE2__)
+           "SSE2",
+#elif defined(__ARM_NEON)
+           "NEON",
+#else
+           "scalar",
+#endif
+           rate);
+
+    return (failures != 0) ? 1 : 0;
+}
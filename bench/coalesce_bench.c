@@ -0,0 +1,253 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        coalesce_bench.c
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file coalesce_bench.c
+ * @brief Wakeups per hour of a simulated 32-sensor board, with each sensor
+ *        at its own period and phase, and coalesced onto shared ticks.
+ *
+ * "planned" counts sampling wakeups from the plan. "measured" runs an
+ * hour of blocking readings from the timing wheel, each on a clock kept
+ * in step with the simulator. Uncoalesced, every sensor has its own
+ * wheel entry and is read alone. Coalesced, every group has one entry,
+ * and the sensors due on its tick are read in one
+ * lmt_get_pulse_count_multi call. A wakeup is one such reading; the
+ * timer wakeups within it (drain and capture) are counted apart. Exits
+ * non-zero if a reading fails or returns the wrong count, or if the
+ * measured wakeups are more than TOLERANCE_PCT off the plan.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "lmt01_coalesce.h"
+#include "lmt01_wheel.h"
+#include "lmt01_sim.h"
+
+#define SENSORS         32
+#define SLACK_MS        400
+#define HOUR_MS         3600000ul
+#define TOLERANCE_PCT   1
+
+/* A blocking reading takes up to about 150 ms, so the CPU can keep up
+   with every sensor read on its own */
+static const uint32_t periods[SENSORS] = {
+     8000,  8080,  7920, 16000, 16400, 40000, 39200,  4000,
+     4080,  2000, 80000, 78400, 24000, 24800, 12000, 12160,
+   480000,240000,160000,120000,  9600, 10000,  6400,  6560,
+     4800, 20000, 60000, 56000,  3200,  2664, 32000, 48000
+};
+
+/*!
+ * @brief  One wheel entry: a sensor read alone, or a coalesced group
+ */
+typedef struct
+{
+    lmt_wheel_entry_t entry;
+
+    /* Sensor, or group of the plan */
+    uint32_t id;
+
+    /* Ticks fired so far, and the tick period (ms) */
+    uint32_t tick;
+    uint32_t tick_ms;
+
+    /* Readings are counted until an hour after the first */
+    uint32_t end_ms;
+
+} job_t;
+
+static lmt_wheel_t wheel;
+static lmt_sim_sensor_t sensors[SENSORS];
+static lmt_sim_timer_t timers[SENSORS];
+static lmt01_dev_t devs[SENSORS];
+static job_t jobs[SENSORS];
+static const lmt_coalesce_t *plan;
+
+/* Run totals */
+static uint32_t wakeups, failed, max_late_ms;
+
+/* Read the sensors of a job due on this tick */
+static void job_fire(lmt_wheel_entry_t *entry)
+{
+    job_t *job = entry->ctx;
+    const lmt01_dev_t *due[SENSORS];
+    uint32_t idx[SENSORS];
+    uint32_t pulses[SENSORS];
+    lmt_status_t rslts[SENSORS];
+    uint32_t i, n = 0, late;
+
+    late = (uint32_t)(lmt_sim_now_us() / 1000) - wheel.now;
+
+    if (late > max_late_ms)
+        max_late_ms = late;
+
+    if (plan == NULL)
+    {
+        idx[n++] = job->id;
+    }
+    else
+    {
+        for (i = 0; i < SENSORS; i++)
+        {
+            if (plan[i].group == job->id && lmt_coalesce_due(&plan[i], job->tick))
+                idx[n++] = i;
+        }
+    }
+
+    for (i = 0; i < n; i++)
+        due[i] = &devs[idx[i]];
+
+    if (n != 0 && (int32_t)(wheel.now - job->end_ms) < 0)
+    {
+        wakeups++;
+
+        if (n == 1)
+            rslts[0] = lmt_get_pulse_count(due[0], &pulses[0]);
+        else
+            lmt_get_pulse_count_multi(due, n, pulses, rslts);
+
+        for (i = 0; i < n; i++)
+        {
+            if (rslts[i] != LMT_OK || pulses[i] != sensors[idx[i]].pulses)
+                failed++;
+        }
+    }
+
+    job->tick++;
+    lmt_wheel_add(&wheel, entry, job->tick_ms);
+}
+
+/* Run an hour of readings from each job's first, return the wakeups */
+static uint32_t run(const lmt_coalesce_t *coalesced, uint32_t *timer_wakeups)
+{
+    uint32_t jobs_n = 0, last_end = 0;
+    uint32_t i, j, next, target, now_ms, start;
+    job_t *job;
+
+    lmt_sim_reset();
+    lmt_wheel_init(&wheel, 0);
+    plan = coalesced;
+    wakeups = failed = max_late_ms = 0;
+
+    for (i = 0; i < SENSORS; i++)
+    {
+        lmt_sim_sensor_init(&sensors[i], 25.0f);
+        sensors[i].phase_us = (uint64_t)(rand() % 104) * 1000;
+        lmt_sim_dev_init(&devs[i], &timers[i], &sensors[i]);
+    }
+
+    /* One job per sensor, or per group */
+    for (i = 0; i < SENSORS; i++)
+    {
+        if (plan != NULL)
+        {
+            for (j = 0; j < i && plan[j].group != plan[i].group; j++);
+
+            if (j != i)
+                continue;
+        }
+
+        job = &jobs[jobs_n++];
+        *job = (job_t){0};
+        job->id = (plan != NULL) ? plan[i].group : i;
+        job->tick_ms = (plan != NULL) ? plan[i].tick_ms : periods[i];
+        job->entry.cb = job_fire;
+        job->entry.ctx = job;
+
+        /* Each at its own phase, once the sensors are up */
+        start = 2 * LMT_SIM_PERIOD_US / 1000 + (uint32_t)rand() % job->tick_ms;
+        job->end_ms = start + HOUR_MS;
+        lmt_wheel_add(&wheel, &job->entry, start);
+
+        if (job->end_ms > last_end)
+            last_end = job->end_ms;
+    }
+
+    /* Wheel time follows the simulator. A reading that runs past the
+       next tick makes that tick late; it still fires. */
+    while (wheel.now < last_end && (next = lmt_wheel_next(&wheel)) != UINT32_MAX)
+    {
+        target = wheel.now + next;
+        now_ms = (uint32_t)(lmt_sim_now_us() / 1000);
+
+        if ((int32_t)(target - now_ms) > 0)
+            lmt_sim_advance_us((uint64_t)(target - now_ms) * 1000);
+        else
+            target = now_ms;
+
+        lmt_wheel_advance(&wheel, target);
+    }
+
+    for (i = 0; i < jobs_n; i++)
+        lmt_wheel_cancel(&wheel, &jobs[i].entry);
+
+    *timer_wakeups = lmt_sim_power()->sleeps + lmt_sim_power()->delays;
+
+    return wakeups;
+}
+
+/* Within TOLERANCE_PCT */
+static int close_to(uint32_t measured, uint32_t planned)
+{
+    uint32_t diff = (measured > planned) ? measured - planned : planned - measured;
+
+    return (uint64_t)diff * 100 <= (uint64_t)planned * TOLERANCE_PCT;
+}
+
+int main(void)
+{
+    lmt_coalesce_t coalesced[SENSORS];
+    uint32_t groups, i, m, planned, measured, timer_wakeups;
+    int ok = 1;
+
+    for (i = 0; i < SENSORS; i++)
+        coalesced[i].period_ms = periods[i];
+
+    lmt_coalesce_plan(coalesced, SENSORS, SLACK_MS, &groups);
+
+    srand(1);
+    printf("%u sensors, %u ms slack, %u groups\n", SENSORS, SLACK_MS, groups);
+    printf("%-12s %10s %10s %10s %8s %8s\n", "wakeups/h", "planned", "measured", "timer", "late ms", "failed");
+
+    for (m = 0; m < 2; m++)
+    {
+        planned = lmt_coalesce_wakeups_per_hour(coalesced, SENSORS, (uint8_t)m);
+        measured = run(m ? coalesced : NULL, &timer_wakeups);
+
+        printf("%-12s %10u %10u %10u %8u %8u\n", m ? "after" : "before",
+               planned, measured, timer_wakeups, max_late_ms, failed);
+
+        if (failed != 0 || !close_to(measured, planned))
+            ok = 0;
+    }
+
+    if (!ok)
+        printf("measured wakeups off the plan, or readings failed\n");
+
+    return ok ? 0 : 1;
+}
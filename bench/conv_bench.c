@@ -0,0 +1,308 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        conv_bench.c
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file conv_bench.c
+ * @brief Exhaustive check and timing of the pulse-to-temperature
+ *        conversion kernels. Every kernel is run over every count from
+ *        0 to 65535 and compared with a long double reference built from
+ *        the same lut and EQU formula. It reports the largest error and
+ *        checks the boundaries: the no-pulse sentinel, exact values at
+ *        the lut points, monotonicity, and lmt_temperature_to_pulses()
+ *        as the inverse of EQU, NaN and out-of-range input included.
+ *        Exits non-zero on any mismatch.
+ *
+ * When a kernel is added, add it to kernels[] with its reference.
+ */
+#define _POSIX_C_SOURCE 199309L
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "lmt01.h"
+
+#define COUNTS      65536u
+#define ROUNDS      50
+
+/* Largest error allowed against the reference: float rounding of the
+   result, one part in 2^23, and at least TOL_C (*C) */
+#define TOL_C       1e-5L
+
+/* Datasheet table the driver's lut holds: *C, pulses */
+static const int16_t ref_lut[21][2] = {
+    {-50, 26}, {-40, 181}, {-30, 338}, {-20, 494}, {-10, 651}, {0, 808},
+    {10, 966}, {20, 1125}, {30, 1284}, {40, 1443}, {50, 1602}, {60, 1762},
+    {70, 1923}, {80, 2084}, {90, 2245}, {100, 2407}, {110, 2569}, {120, 2731},
+    {130, 2893}, {140, 3057}, {150, 3218}
+};
+
+typedef float (*kernel_fptr_t)(uint32_t pulses);
+typedef long double (*ref_fptr_t)(uint32_t pulses);
+
+static long double ref_equ(uint32_t pulses)
+{
+    return (long double)pulses * 256.0L / 4096.0L - 50.0L;
+}
+
+/* Linear between table points, end segments extended */
+static long double ref_lut_interp(uint32_t pulses)
+{
+    uint32_t i;
+
+    for (i = 0; i < 19; i++)
+    {
+        if (pulses <= (uint32_t)ref_lut[i + 1][1])
+            break;
+    }
+
+    return ref_lut[i][0] + ((long double)pulses - ref_lut[i][1]) *
+           (ref_lut[i + 1][0] - ref_lut[i][0]) / (ref_lut[i + 1][1] - ref_lut[i][1]);
+}
+
+static float kernel_equ(uint32_t pulses)
+{
+    return lmt_pulses_to_temperature(pulses, CONV_TYPE_EQU);
+}
+
+static float kernel_lut(uint32_t pulses)
+{
+    return lmt_pulses_to_temperature(pulses, CONV_TYPE_LUT);
+}
+
+static const struct
+{
+    const char *name;
+    kernel_fptr_t fn;
+    ref_fptr_t ref;
+    uint8_t table;
+} kernels[] = {
+    { "EQU", kernel_equ, ref_equ,        0 },
+    { "LUT", kernel_lut, ref_lut_interp, 1 },
+};
+
+#define KERNELS (sizeof(kernels) / sizeof(kernels[0]))
+
+static volatile float sink;
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static long double absl(long double v)
+{
+    return (v < 0) ? -v : v;
+}
+
+/* Every count against the reference; returns the number of failures */
+static uint32_t check(uint32_t k)
+{
+    long double err, max_err = 0;
+    uint32_t p, worst = 0, failures = 0;
+    float t, prev = 0;
+    uint32_t i;
+
+    /* 0 means no pulses: the -1 sentinel, not a temperature */
+    if (kernels[k].fn(0) != -1.0f)
+    {
+        printf("  %s: count 0 gives %f, not -1\n", kernels[k].name, kernels[k].fn(0));
+        failures++;
+    }
+
+    for (p = 1; p < COUNTS; p++)
+    {
+        t = kernels[k].fn(p);
+        err = absl((long double)t - kernels[k].ref(p));
+
+        if (err > max_err)
+        {
+            max_err = err;
+            worst = p;
+        }
+
+        if (err > TOL_C && err > absl(kernels[k].ref(p)) * FLT_EPSILON)
+            failures++;
+
+        /* Threshold comparisons rely on this */
+        if (p > 1 && t < prev)
+        {
+            printf("  %s: not monotonic at %u\n", kernels[k].name, p);
+            failures++;
+        }
+
+        prev = t;
+    }
+
+    /* Table points land exactly on the table temperature */
+    for (i = 0; kernels[k].table && i < 21; i++)
+    {
+        if (kernels[k].fn(ref_lut[i][1]) != (float)ref_lut[i][0])
+        {
+            printf("  %s: %u pulses gives %f, not %d\n", kernels[k].name, ref_lut[i][1],
+                   kernels[k].fn(ref_lut[i][1]), ref_lut[i][0]);
+            failures++;
+        }
+    }
+
+    printf("  %-6s max error %.3Le *C at %u pulses, %u failures\n", kernels[k].name,
+           max_err, worst, failures);
+
+    return failures;
+}
+
+/* lmt_temperature_to_pulses is the smallest count reading at least temp */
+static uint32_t check_inverse(void)
+{
+    uint32_t failures = 0;
+    uint32_t p;
+    int32_t c;
+    float temp;
+
+    for (c = -5000; c <= 15000; c++)
+    {
+        temp = c / 100.0f;
+        p = lmt_temperature_to_pulses(temp);
+
+        if (kernel_equ(p) < temp || (p > 1 && kernel_equ(p - 1) >= temp))
+        {
+            if (failures++ < 5)
+                printf("  inverse: %.2f *C gives %u pulses (%f, %f)\n", temp, p,
+                       kernel_equ(p - 1), kernel_equ(p));
+        }
+    }
+
+    printf("  %-6s %u mismatches over -50 .. 150 *C\n", "inv", failures);
+
+    return failures;
+}
+
+/* Inputs outside the sensor range, down to NaN and infinities */
+static uint32_t check_inverse_edges(void)
+{
+    static const struct
+    {
+        float temp;
+        uint32_t pulses;
+    } edges[] = {
+        { -INFINITY,    1 },
+        { -FLT_MAX,     1 },
+        { -273.15f,     1 },
+        { -50.0f,       1 },
+        { 150.0f,       3200 },
+        { 2.0e8f,       3200000800u },
+        { 3.0e8f,       UINT32_MAX },
+        { FLT_MAX,      UINT32_MAX },
+        { INFINITY,     UINT32_MAX },
+        { NAN,          UINT32_MAX },
+    };
+    uint32_t failures = 0;
+    uint32_t i, p;
+
+    for (i = 0; i < sizeof(edges) / sizeof(edges[0]); i++)
+    {
+        p = lmt_temperature_to_pulses(edges[i].temp);
+
+        if (p != edges[i].pulses)
+        {
+            printf("  inverse: %g *C gives %u pulses, not %u\n", edges[i].temp, p, edges[i].pulses);
+            failures++;
+        }
+    }
+
+    printf("  %-6s %u mismatches at the edges\n", "inv", failures);
+
+    return failures;
+}
+
+int main(void)
+{
+    uint32_t k, p, r, failures = 0;
+    long double diff, max_diff = 0;
+    uint32_t at = 0;
+    double t0, ns;
+    float acc;
+
+    printf("equivalence, counts 0 .. %u\n", COUNTS - 1);
+
+    for (k = 0; k < KERNELS; k++)
+        failures += check(k);
+
+    failures += check_inverse();
+    failures += check_inverse_edges();
+
+    /* The kernels model the sensor differently: report, do not fail */
+    for (p = ref_lut[0][1]; p <= (uint32_t)ref_lut[20][1]; p++)
+    {
+        diff = absl((long double)kernel_equ(p) - kernel_lut(p));
+
+        if (diff > max_diff)
+        {
+            max_diff = diff;
+            at = p;
+        }
+    }
+
+    printf("  EQU vs LUT over the table range: up to %.3Lf *C (at %u pulses)\n", max_diff, at);
+
+    /* A real reading that converts to the no-pulse sentinel */
+    for (k = 0; k < KERNELS; k++)
+    {
+        for (p = 1; p < COUNTS; p++)
+        {
+            if (kernels[k].fn(p) == -1.0f)
+                printf("  %s: %u pulses is -1 *C, same as the no-pulse sentinel\n",
+                       kernels[k].name, p);
+        }
+    }
+
+    printf("\nspeed\n");
+
+    for (k = 0; k < KERNELS; k++)
+    {
+        acc = 0;
+        t0 = now_s();
+
+        for (r = 0; r < ROUNDS; r++)
+        {
+            for (p = 1; p < COUNTS; p++)
+                acc += kernels[k].fn(p);
+        }
+
+        ns = (now_s() - t0) * 1e9 / ((double)ROUNDS * (COUNTS - 1));
+        sink = acc;
+        printf("  %-6s %7.2f ns/conversion\n", kernels[k].name, ns);
+    }
+
+    return (failures != 0) ? 1 : 0;
+}
@@ -0,0 +1,239 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        coro_bench.cpp
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file coro_bench.cpp
+ * @brief N concurrent readings on real time: coroutines on one thread
+ *        (lmt01_coro.hpp) against one blocking thread per sensor. The
+ *        sensors are the simulator's model driven by steady_clock, so
+ *        both run the same acquisition. Reports wall time, readings that
+ *        came back right, and memory held per reading in flight.
+ */
+#include <pthread.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "lmt01_coro.hpp"
+#include "lmt01_sim.h"
+
+/* Heap bytes allocated, to size the coroutine frames */
+static std::atomic<size_t> heap_bytes{0};
+
+void *operator new(size_t n)
+{
+    heap_bytes += n;
+
+    if (void *p = std::malloc(n))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+/* Counter on the real clock, counting the simulated sensor's output */
+struct rt_timer
+{
+    lmt_sim_sensor_t sensor;
+    uint8_t running;
+    uint64_t since_us;
+    uint32_t base;
+};
+
+static std::chrono::steady_clock::time_point t0;
+
+/* Sensors have been running for two cycles at t0 */
+static uint64_t rt_now_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now() - t0).count() + 2 * LMT_SIM_PERIOD_US;
+}
+
+static uint32_t rt_count(const rt_timer *t)
+{
+    if (!t->running)
+        return t->base;
+
+    return t->base + (uint32_t)(lmt_sim_pulses_before(&t->sensor, rt_now_us()) -
+                                lmt_sim_pulses_before(&t->sensor, t->since_us));
+}
+
+static void rt_start_timer(void *timer)
+{
+    rt_timer *t = static_cast<rt_timer *>(timer);
+
+    t->since_us = rt_now_us();
+    t->running = 1;
+}
+
+static void rt_stop_timer(void *timer)
+{
+    rt_timer *t = static_cast<rt_timer *>(timer);
+
+    t->base = rt_count(t);
+    t->running = 0;
+}
+
+static void rt_set_timer_cnt(void *timer, uint32_t *cnt)
+{
+    rt_timer *t = static_cast<rt_timer *>(timer);
+
+    t->base = *cnt;
+    t->since_us = rt_now_us();
+}
+
+static void rt_get_timer_cnt(void *timer, uint32_t *cnt)
+{
+    *cnt = rt_count(static_cast<rt_timer *>(timer));
+}
+
+static void rt_delay_ms(uint32_t ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+struct sensor_set
+{
+    std::vector<rt_timer> timers;
+    std::vector<lmt01_dev_t> devs;
+    std::vector<lmt::reading> results;
+
+    explicit sensor_set(uint32_t n) : timers(n), devs(n), results(n)
+    {
+        for (uint32_t i = 0; i < n; i++)
+        {
+            lmt_sim_sensor_init(&timers[i].sensor, 25.0f);
+            timers[i].sensor.phase_us = (uint64_t)(i * 7919u) % LMT_SIM_PERIOD_US;
+
+            devs[i] = lmt01_dev_t{};
+            devs[i].timer = &timers[i];
+            devs[i].start_timer = rt_start_timer;
+            devs[i].stop_timer = rt_stop_timer;
+            devs[i].set_timer_cnt = rt_set_timer_cnt;
+            devs[i].get_timer_cnt = rt_get_timer_cnt;
+            devs[i].delay_ms = rt_delay_ms;
+        }
+    }
+
+    uint32_t correct() const
+    {
+        uint32_t ok = 0;
+
+        for (size_t i = 0; i < results.size(); i++)
+            ok += (results[i].rslt == LMT_OK && results[i].pulses == timers[i].sensor.pulses);
+
+        return ok;
+    }
+};
+
+static lmt::task sample(lmt::executor &ex, sensor_set &set, uint32_t i)
+{
+    set.results[i] = co_await lmt::read(&set.devs[i], ex);
+}
+
+static void run_coro(uint32_t n)
+{
+    sensor_set set(n);
+    lmt::executor ex;
+    size_t before;
+    double ms;
+
+    t0 = std::chrono::steady_clock::now();
+    before = heap_bytes;
+
+    for (uint32_t i = 0; i < n; i++)
+        sample(ex, set, i);
+
+    size_t frames = heap_bytes - before;
+
+    ex.run();
+    ms = (rt_now_us() - 2 * LMT_SIM_PERIOD_US) / 1000.0;
+
+    std::printf("  %-10s %6u %9.1f %6u %12zu\n", "coroutine", n, ms, set.correct(),
+                frames / n);
+}
+
+static void run_threads(uint32_t n)
+{
+    sensor_set set(n);
+    std::vector<std::thread> threads;
+    pthread_attr_t attr;
+    size_t stack = 0;
+    double ms;
+
+    pthread_attr_init(&attr);
+    pthread_attr_getstacksize(&attr, &stack);
+    pthread_attr_destroy(&attr);
+
+    t0 = std::chrono::steady_clock::now();
+    threads.reserve(n);
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        threads.emplace_back([&set, i] {
+            set.results[i].rslt = lmt_get_pulse_count(&set.devs[i], &set.results[i].pulses);
+        });
+    }
+
+    for (auto &t : threads)
+        t.join();
+
+    ms = (rt_now_us() - 2 * LMT_SIM_PERIOD_US) / 1000.0;
+
+    std::printf("  %-10s %6u %9.1f %6u %12zu\n", "thread", n, ms, set.correct(), stack);
+}
+
+int main()
+{
+    static const uint32_t counts[] = { 10, 100, 1000 };
+
+    std::printf("  %-10s %6s %9s %6s %12s\n", "model", "reads", "wall ms", "ok",
+                "bytes/read");
+
+    for (uint32_t n : counts)
+    {
+        run_coro(n);
+        run_threads(n);
+    }
+
+    return 0;
+}
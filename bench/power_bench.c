@@ -0,0 +1,252 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        power_bench.c
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+/*! @file power_bench.c
+ * @brief Energy per reading of each acquisition mode at several sample
+ *        rates, ranked. Each reading is costed twice: by the simulator's
+ *        power model (duty cycle, sensor supply time), and from the
+ *        driver's energy meter with the same current figures, which
+ *        should agree. The figures can be given on the command line:
+ *
+ *        power_bench [run_ua sleep_ua sensor_ua supply_mv hal_us]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "lmt01.h"
+#include "lmt01_sim.h"
+
+#define READINGS    40
+#define MODES       6
+
+enum mode
+{
+    MODE_DELAY,
+    MODE_SLEEP,
+    MODE_GAP,
+    MODE_NONBLOCKING,
+    MODE_PERIODIC,
+    MODE_GATED
+};
+
+static const char *const names[MODES] = {
+    "blocking, delay_ms",
+    "blocking, sleep_until",
+    "gap timer, sleep_until",
+    "non-blocking, caller sleeps",
+    "periodic grid, sleep_until",
+    "power-gated, sleep_until"
+};
+
+static const uint32_t periods_ms[] = { 5000, 1000, 250 };
+
+/* Current figures, see LMT_SIM_* defaults */
+static lmt_sim_power_t figures = {
+    LMT_SIM_RUN_UA, LMT_SIM_SLEEP_UA, LMT_SIM_SENSOR_UA, LMT_SIM_SUPPLY_MV, LMT_SIM_HAL_US,
+    0, 0, 0, 0, 0
+};
+
+typedef struct
+{
+    enum mode mode;
+    double sim_uj;
+    double meter_uj;
+    double awake_us;
+    double sensor_us;
+    double hal_calls;
+    uint32_t ok;
+} result_t;
+
+/* Energy of one reading period (uJ) from the meter. Outside the driver
+   the MCU sleeps. */
+static double meter_uj(const lmt_energy_t *meter, uint32_t period_us)
+{
+    lmt_sim_power_t pw = figures;
+
+    pw.awake_us = meter->awake_us;
+
+    return lmt_sim_energy_uj(&pw, period_us, meter->sensor_us);
+}
+
+static lmt_status_t read_once(const lmt01_dev_t *dev, enum mode mode, lmt_periodic_t *pd,
+                              uint32_t *pulses)
+{
+    lmt_read_t rd = {0};
+    lmt_status_t rslt;
+
+    switch (mode)
+    {
+    case MODE_NONBLOCKING:
+        rslt = lmt_read_start(dev, &rd);
+
+        while (rslt == LMT_BUSY)
+        {
+            lmt_sim_sleep_until(dev->timer, (uint32_t)lmt_sim_now_us() + rd.wait_ms * 1000);
+            rslt = lmt_read_step(&rd);
+        }
+
+        *pulses = rd.pulses;
+        return rslt;
+
+    case MODE_PERIODIC:
+        return lmt_periodic_next(dev, pd, pulses);
+
+    case MODE_GATED:
+        lmt_set_power(dev, 1);
+        rslt = lmt_get_pulse_count(dev, pulses);
+        lmt_set_power(dev, 0);
+        return rslt;
+
+    default:
+        return lmt_get_pulse_count(dev, pulses);
+    }
+}
+
+static result_t run(enum mode mode, uint32_t period_ms)
+{
+    lmt_sim_sensor_t sensor;
+    lmt_sim_timer_t timer;
+    lmt01_dev_t dev;
+    lmt_energy_t meter = {0};
+    lmt_periodic_t pd = {0};
+    lmt_sim_power_t *pw;
+    result_t r = {0};
+    uint64_t t0, on0, elapsed;
+    uint32_t pulses;
+    uint32_t i;
+
+    r.mode = mode;
+
+    lmt_sim_reset();
+    lmt_sim_sensor_init(&sensor, 25.0f);
+    lmt_sim_dev_init(&dev, &timer, &sensor);
+
+    if (mode == MODE_DELAY)
+        dev.sleep_until = NULL;
+
+    if (mode == MODE_GAP)
+    {
+        dev.arm_gap_timer = lmt_sim_arm_gap_timer;
+        dev.gap_expired = lmt_sim_gap_expired;
+    }
+
+    if (mode == MODE_PERIODIC)
+    {
+        pd.period_ms = period_ms;
+
+        if (lmt_periodic_start(&dev, &pd) != LMT_OK)
+            return r;
+    }
+
+    dev.energy = &meter;
+
+    if (mode == MODE_GATED)
+        lmt_set_power(&dev, 0);
+
+    /* One reading first: the meter's supply time runs from the previous
+       reading. The model starts from here too, setup excluded. */
+    read_once(&dev, mode, &pd, &pulses);
+
+    pw = lmt_sim_power();
+    *pw = figures;
+    t0 = lmt_sim_now_us();
+    on0 = lmt_sim_sensor_on_us(&sensor);
+
+    for (i = 0; i < READINGS; i++)
+    {
+        /* The periodic grid paces itself */
+        if (mode != MODE_PERIODIC)
+            lmt_sim_advance_us(t0 + (uint64_t)(i + 1) * period_ms * 1000 - lmt_sim_now_us());
+
+        if (read_once(&dev, mode, &pd, &pulses) != LMT_OK)
+            continue;
+
+        r.ok++;
+        /* The grid rounds the period to whole sensor cycles */
+        r.meter_uj += meter_uj(&meter, (mode == MODE_PERIODIC) ? pd.period_us : period_ms * 1000);
+        r.sensor_us += meter.sensor_us;
+        r.hal_calls += meter.hal_calls;
+    }
+
+    elapsed = lmt_sim_now_us() - t0;
+    r.sim_uj = lmt_sim_energy_uj(pw, elapsed, lmt_sim_sensor_on_us(&sensor) - on0) / READINGS;
+    r.awake_us = (double)pw->awake_us / READINGS;
+
+    if (r.ok != 0)
+    {
+        r.meter_uj /= r.ok;
+        r.sensor_us /= r.ok;
+        r.hal_calls /= r.ok;
+    }
+
+    return r;
+}
+
+int main(int argc, char **argv)
+{
+    result_t results[MODES], tmp;
+    uint32_t p, m, k;
+
+    if (argc > 1) figures.run_ua = (uint32_t)atoi(argv[1]);
+    if (argc > 2) figures.sleep_ua = (uint32_t)atoi(argv[2]);
+    if (argc > 3) figures.sensor_ua = (uint32_t)atoi(argv[3]);
+    if (argc > 4) figures.supply_mv = (uint32_t)atoi(argv[4]);
+    if (argc > 5) figures.hal_us = (uint32_t)atoi(argv[5]);
+
+    printf("run %u uA, sleep %u uA, sensor %u uA, %u mV, %u us/HAL call\n",
+           figures.run_ua, figures.sleep_ua, figures.sensor_ua, figures.supply_mv, figures.hal_us);
+
+    for (p = 0; p < sizeof(periods_ms) / sizeof(periods_ms[0]); p++)
+    {
+        for (m = 0; m < MODES; m++)
+            results[m] = run((enum mode)m, periods_ms[p]);
+
+        /* Rank, least energy first */
+        for (m = 1; m < MODES; m++)
+        {
+            for (k = m; k > 0 && results[k].sim_uj < results[k - 1].sim_uj; k--)
+            {
+                tmp = results[k];
+                results[k] = results[k - 1];
+                results[k - 1] = tmp;
+            }
+        }
+
+        printf("\n%.1f Hz\n  %-28s %9s %9s %8s %10s %7s %6s\n", 1000.0 / periods_ms[p], "mode",
+               "uJ/read", "meter uJ", "awake us", "sensor us", "hal/rd", "ok");
+
+        for (m = 0; m < MODES; m++)
+        {
+            printf("  %-28s %9.2f %9.2f %8.0f %10.0f %7.1f %3u/%u\n", names[results[m].mode],
+                   results[m].sim_uj, results[m].meter_uj, results[m].awake_us, results[m].sensor_us,
+                   results[m].hal_calls, results[m].ok, READINGS);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        sched_bench.c
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file sched_bench.c
+ * @brief Deadline scheduler under load: simulated battery cell sensors
+ *        (critical) and ambient sensors sharing one counter, with and
+ *        without priorities. Demand is about twice what one counter can
+ *        read.
+ */
+#include <stdio.h>
+
+#include "lmt01_sched.h"
+#include "lmt01_sim.h"
+
+#define CELLS       4
+#define AMBIENT     12
+#define TASKS       (CELLS + AMBIENT)
+#define RUN_MS      600000ul
+
+static lmt_sim_sensor_t sensors[TASKS];
+static lmt_sim_timer_t timers[TASKS];
+static lmt01_dev_t devs[TASKS];
+static lmt_sched_task_t tasks[TASKS];
+
+static void report(const char *name, uint32_t from, uint32_t to)
+{
+    uint32_t released = 0, done = 0, failed = 0, misses = 0, shed = 0;
+    uint32_t i;
+
+    for (i = from; i < to; i++)
+    {
+        released += tasks[i].released;
+        done += tasks[i].done;
+        failed += tasks[i].failed;
+        misses += tasks[i].misses;
+        shed += tasks[i].shed;
+    }
+
+    printf("  %-8s %9u %9u %9u %9u %9u %8.1f%%\n", name, released, done, failed, misses, shed,
+           100.0 * done / released);
+}
+
+static void run(uint8_t prioritised)
+{
+    lmt_sched_t sched;
+    uint32_t now = 0, wait;
+    uint32_t i;
+
+    lmt_sim_reset();
+
+    for (i = 0; i < TASKS; i++)
+    {
+        lmt_sim_sensor_init(&sensors[i], 25.0f);
+        sensors[i].phase_us = (uint64_t)i * 6500;
+        lmt_sim_dev_init(&devs[i], &timers[i], &sensors[i]);
+
+        tasks[i] = (lmt_sched_task_t){0};
+        tasks[i].dev = &devs[i];
+        tasks[i].period_ms = 1000;
+        tasks[i].priority = (prioritised && i < CELLS) ? 1 : 0;
+    }
+
+    lmt_sched_init(&sched, tasks, TASKS, now);
+
+    /* Spread the releases over the period */
+    for (i = 0; i < TASKS; i++)
+        tasks[i].release_ms = (i * 397) % 1000;
+
+    while (now < RUN_MS)
+    {
+        wait = lmt_sched_poll(&sched, now);
+        lmt_sim_advance_us((uint64_t)wait * 1000);
+        now += wait;
+    }
+
+    printf("%s\n  %-8s %9s %9s %9s %9s %9s %9s\n", prioritised ? "EDF + priority" : "EDF only",
+           "", "released", "in time", "failed", "missed", "shed", "rate");
+    report("cells", 0, CELLS);
+    report("ambient", CELLS, TASKS);
+}
+
+int main(void)
+{
+    run(0);
+    run(1);
+
+    return 0;
+}
@@ -0,0 +1,207 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        wheel_bench.c
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file wheel_bench.c
+ * @brief Scheduler overhead per reading of the timing wheel, for 10 to
+ *        100k sensors with periods spread over 200 .. 1199 ms, each
+ *        longer than a reading with its drain windows.
+ *
+ * "wheel" times the wheel alone, each timer re-queued once per period.
+ * "reader" drives full non-blocking readings of simulated sensors, so it
+ * includes the acquisition engine and the simulator; the difference is
+ * the cost of the reading itself. Every reading is checked: it must
+ * start one period after the previous one and return the sensor's
+ * count. HAL calls take no simulated time here, so the simulator clock
+ * stays on the wheel's tick. Exits non-zero if any reading was off.
+ */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "lmt01_wheel.h"
+#include "lmt01_sim.h"
+
+#define READINGS    1000000ul
+
+static lmt_wheel_t wheel;
+static unsigned long readings;
+
+/* Reader mode: the sensors and readers, and readings that were late,
+   early, failed or wrong */
+static lmt_sim_sensor_t *sensors;
+static lmt_wheel_reader_t *rdrs;
+static uint32_t *last_start;
+static unsigned long off_period, failed;
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint32_t period_of(uint32_t i)
+{
+    return 200 + (i * 7919u) % 1000;
+}
+
+static void timer_fire(lmt_wheel_entry_t *entry)
+{
+    readings++;
+    lmt_wheel_add(&wheel, entry, (uint32_t)(uintptr_t)entry->ctx);
+}
+
+static void reading_done(void *ctx, lmt_status_t rslt, uint32_t pulses)
+{
+    uint32_t i = (uint32_t)(uintptr_t)ctx;
+    lmt_wheel_reader_t *rdr = &rdrs[i];
+
+    readings++;
+
+    if (rslt != LMT_OK || pulses != sensors[i].pulses)
+        failed++;
+
+    if (last_start[i] != UINT32_MAX && rdr->start_ms - last_start[i] != rdr->period_ms)
+        off_period++;
+
+    last_start[i] = rdr->start_ms;
+}
+
+/* Run the wheel until READINGS have been taken, return ns per reading */
+static double run(void)
+{
+    uint32_t next;
+    double t0 = now_s();
+
+    readings = 0;
+
+    /* The simulator clock is the wheel tick, in us */
+    while (readings < READINGS && (next = lmt_wheel_next(&wheel)) != UINT32_MAX)
+    {
+        lmt_sim_advance_us((uint64_t)(wheel.now + next) * 1000 - lmt_sim_now_us());
+        lmt_wheel_advance(&wheel, wheel.now + next);
+    }
+
+    return (now_s() - t0) * 1e9 / readings;
+}
+
+static double bench_wheel(uint32_t n)
+{
+    lmt_wheel_entry_t *entries = calloc(n, sizeof(*entries));
+    uint32_t i;
+    double ns;
+
+    lmt_sim_reset();
+    lmt_wheel_init(&wheel, 0);
+
+    for (i = 0; i < n; i++)
+    {
+        entries[i].cb = timer_fire;
+        entries[i].ctx = (void *)(uintptr_t)period_of(i);
+        lmt_wheel_add(&wheel, &entries[i], rand() % period_of(i));
+    }
+
+    ns = run();
+    free(entries);
+
+    return ns;
+}
+
+static double bench_reader(uint32_t n)
+{
+    lmt_sim_timer_t *timers = calloc(n, sizeof(*timers));
+    lmt01_dev_t *devs = calloc(n, sizeof(*devs));
+    uint32_t i;
+    double ns;
+
+    sensors = calloc(n, sizeof(*sensors));
+    rdrs = calloc(n, sizeof(*rdrs));
+    last_start = calloc(n, sizeof(*last_start));
+
+    lmt_sim_reset();
+    lmt_sim_power()->hal_us = 0;
+    lmt_wheel_init(&wheel, 0);
+
+    for (i = 0; i < n; i++)
+    {
+        lmt_sim_sensor_init(&sensors[i], (float)(i % 100));
+        sensors[i].phase_us = (uint64_t)(rand() % 104) * 1000;
+        lmt_sim_dev_init(&devs[i], &timers[i], &sensors[i]);
+        last_start[i] = UINT32_MAX;
+
+        /* First reading once the sensor is up */
+        rdrs[i].period_ms = period_of(i);
+        rdrs[i].done_cb = reading_done;
+        rdrs[i].done_ctx = (void *)(uintptr_t)i;
+        lmt_wheel_reader_start(&wheel, &rdrs[i], &devs[i],
+                               LMT_SIM_PERIOD_US / 1000 + rand() % period_of(i));
+    }
+
+    ns = run();
+
+    for (i = 0; i < n; i++)
+        lmt_wheel_reader_stop(&rdrs[i]);
+
+    free(sensors);
+    free(timers);
+    free(devs);
+    free(rdrs);
+    free(last_start);
+
+    return ns;
+}
+
+int main(void)
+{
+    static const uint32_t sizes[] = { 10, 100, 1000, 10000, 100000 };
+    uint32_t i;
+    double wheel_ns, reader_ns;
+    int ok = 1;
+
+    srand(1);
+    printf("%8s %14s %14s %10s %10s\n", "sensors", "wheel ns/rd", "reader ns/rd", "off period", "failed");
+
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        off_period = failed = 0;
+        wheel_ns = bench_wheel(sizes[i]);
+        reader_ns = bench_reader(sizes[i]);
+
+        printf("%8u %14.1f %14.1f %10lu %10lu\n", sizes[i], wheel_ns, reader_ns, off_period, failed);
+
+        if (off_period != 0 || failed != 0)
+            ok = 0;
+    }
+
+    return ok ? 0 : 1;
+}
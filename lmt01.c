@@ -48,22 +48,278 @@
 static lmt_status_t null_ptr_check(const lmt01_dev_t *dev);
 
 /*!
- * @brief This internal API is used to count the number of pulses
- * received in a given period (ms).
+ * @brief This internal API waits until every device of a group has been
+ * quiet for a whole drain window, so that a capture opens in the gap
+ * between bursts.
+ *
+ * @param[in] devs : Structure instances of lmt01_dev.
+ * @param[in] n : Number of devices.
+ * @param[in] drain_ms : Drain window (ms).
+ * @param[in] limit_ms : Longest time spent in windows that saw pulses.
+ *
+ * @return Result of API execution status
+ * @retval LMT_OK once quiet, LMT_E_TIMEOUT if not quiet within limit_ms
+ */
+static lmt_status_t drain_quiet(const lmt01_dev_t *const *devs, uint32_t n,
+                                uint32_t drain_ms, uint32_t limit_ms);
+
+/*!
+ * @brief These internal APIs access a timer. When the register pointers
+ * are set they are used directly for the main timer, otherwise the
+ * device callbacks are called.
+ *
+ * @param[in] dev : Structure instance of lmt01_dev.
+ * @param[in] timer : Timer context (dev->timer or dev->timer_b).
+ */
+static inline void timer_start(const lmt01_dev_t *dev, void *timer);
+static inline void timer_stop(const lmt01_dev_t *dev, void *timer);
+static inline void timer_set(const lmt01_dev_t *dev, void *timer, uint32_t cnt);
+static inline uint32_t timer_get(const lmt01_dev_t *dev, void *timer);
+
+/*!
+ * @brief This internal API resets the pulse counter and starts counting.
+ *
+ * @param[in] dev : Structure instance of lmt01_dev.
+ */
+static void window_open(const lmt01_dev_t *dev);
+
+/*!
+ * @brief This internal API stops counting and returns the pulses counted
+ * since the matching window_open().
  *
  * @param[in] dev : Structure instance of lmt01_dev.
- * @param[in] dev : Period in which to count pulses (ms).
  *
  * @return Number of pulses received from lmt01.
  * @retval pulses
  */
-static uint32_t count_pulses_ms(const lmt01_dev_t *dev, uint32_t period);
+static uint32_t window_close(const lmt01_dev_t *dev);
+
+/*!
+ * @brief This internal API returns the timer context for a ping-pong slot.
+ *
+ * @param[in] dev : Structure instance of lmt01_dev.
+ * @param[in] slot : 0 = timer, 1 = timer_b.
+ *
+ * @return Timer context.
+ */
+static void *stream_timer(const lmt01_dev_t *dev, uint8_t slot);
+
+/*!
+ * @brief This internal API checks whether end-of-burst detection can be
+ * delegated to a hardware gap timer.
+ *
+ * @param[in] dev : Structure instance of lmt01_dev.
+ *
+ * @return Non-zero if both gap timer hooks are set.
+ */
+static uint8_t has_gap_timer(const lmt01_dev_t *dev);
+
+/*!
+ * @brief This internal API checks whether the gap timer has flagged the
+ * end of the burst.
+ *
+ * @param[in] dev : Structure instance of lmt01_dev.
+ *
+ * @return Non-zero if the device has a gap timer and it has expired.
+ */
+static uint8_t gap_ended(const lmt01_dev_t *dev);
+
+/*!
+ * @brief This internal API waits up to limit_ms for the gap timer. With
+ * sleep_until it sleeps once, woken early by the gap timer; with delay_ms
+ * only it checks the gap timer every LMT_PROBE_POLL_MS.
+ *
+ * @param[in] dev : Structure instance of lmt01_dev.
+ * @param[in] limit_ms : Longest wait.
+ *
+ * @return Time waited (ms, rounded up).
+ */
+static uint32_t gap_wait(const lmt01_dev_t *dev, uint32_t limit_ms);
+
+/*!
+ * @brief This internal API closes the capture window of a reading and
+ * reports its result.
+ *
+ * @param[in,out] rd : Acquisition context.
+ */
+static void capture_end(lmt_read_t *rd);
+
+/*!
+ * @brief This internal API checks that the second timer can be driven.
+ * It is only ever accessed through the callbacks.
+ *
+ * @param[in] dev : Structure instance of lmt01_dev.
+ *
+ * @return Non-zero if timer_b and all timer callbacks are set.
+ */
+static uint8_t has_timer_b(const lmt01_dev_t *dev);
+
+/*!
+ * @brief This internal API records the outcome of a presence check or
+ * reading in the device state, if the device has one.
+ *
+ * @param[in] dev : Structure instance of lmt01_dev.
+ * @param[in] rslt : Outcome.
+ */
+static void state_update(const lmt01_dev_t *dev, lmt_status_t rslt);
+
+/*!
+ * @brief This internal API returns the capture poll interval of a
+ * reading, polling for an alarm or the burst signature when poll_ms is 0.
+ */
+static uint32_t poll_of(const lmt_read_t *rd);
+
+/*!
+ * @brief This internal API records a running count for the burst
+ * signature. A sample is mid-burst if the count rose after it.
+ */
+static void signature_sample(lmt_read_t *rd, uint32_t cnt);
+
+/*!
+ * @brief This internal API checks the burst signature of a completed
+ * reading and updates the device health.
+ */
+static void health_update(const lmt_read_t *rd);
+
+/*!
+ * @brief This internal API waits, sleeping through sleep_until if the
+ * device has it, otherwise in delay_ms.
+ *
+ * @param[in] dev : Structure instance of lmt01_dev.
+ * @param[in] ms : Time to wait.
+ */
+static void sleep_ms(const lmt01_dev_t *dev, uint32_t ms);
+
+/*!
+ * @brief This internal API counts HAL calls on the energy meter.
+ *
+ * @param[in] dev : Structure instance of lmt01_dev.
+ * @param[in] calls : Calls made.
+ */
+static inline void hal_count(const lmt01_dev_t *dev, uint32_t calls);
+
+/*!
+ * @brief This internal API reads get_time_us, counted as a HAL call.
+ */
+static inline uint32_t time_us(const lmt01_dev_t *dev);
+
+/*!
+ * @brief This internal API switches the sensor supply and accounts its
+ * on time on the energy meter.
+ *
+ * @param[in] dev : Structure instance of lmt01_dev.
+ * @param[in] on : Non-zero to power the sensor.
+ */
+static void power_set(const lmt01_dev_t *dev, uint8_t on);
+
+/*!
+ * @brief This internal API marks the start of a reading on the energy
+ * meter.
+ */
+static void meter_begin(const lmt01_dev_t *dev);
+
+/*!
+ * @brief This internal API latches the figures of a completed reading on
+ * the energy meter.
+ */
+static void meter_end(const lmt01_dev_t *dev);
+
+/*!
+ * @brief This internal API charges the wait_ms handed to the caller of
+ * the non-blocking API as sleep on the energy meter.
+ */
+static void meter_wait(const lmt_read_t *rd);
+
+/*!
+ * @brief This internal API ends a group read that failed before its
+ * capture window: every device gets rslt and no pulses, and the energy
+ * meter is closed.
+ */
+static void sync_fail(const lmt01_dev_t *const *devs, uint32_t n, uint32_t *pulses,
+                      lmt_status_t *rslts, lmt_status_t rslt);
+
+/*!
+ * @brief This internal API waits for the end of the next burst on an open
+ * window, polling every LMT_PROBE_POLL_MS for up to limit_ms.
+ *
+ * @param[in] dev : Structure instance of lmt01_dev.
+ * @param[in] limit_ms : Longest wait.
+ * @param[out] pulses : Count at the end of the burst.
+ * @param[out] start_us : Time the first pulse was seen (get_time_us).
+ *
+ * The burst start is used rather than its end, as the end moves with the
+ * pulse count, i.e. with temperature.
+ *
+ * @return LMT_OK, LMT_E_DEV_NOT_FOUND without a burst, or LMT_E_TIMEOUT
+ * if it did not end in time.
+ */
+static lmt_status_t burst_end(const lmt01_dev_t *dev, uint32_t limit_ms, uint32_t *pulses, uint32_t *start_us);
+
+/*!
+ * @brief This internal API returns the timing a device acquires with.
+ *
+ * @param[in] dev : Structure instance of lmt01_dev.
+ *
+ * @return Characterised timing if available, else the defaults.
+ */
+static const lmt_timing_t *timing_of(const lmt01_dev_t *dev);
+
+/*!
+ * @brief This internal API clamps a window to the characterisation limits.
+ */
+static uint16_t clamp_ms(uint32_t ms);
+
+/*!
+ * @brief This internal API checks that timing is something
+ * lmt_characterise could have produced: windows within the clamps, a
+ * burst shorter than the period, and a drain plus capture that holds one
+ * whole burst but not two.
+ *
+ * @return 1 if valid, else 0
+ */
+static uint8_t timing_valid(const lmt_timing_t *t);
+
+/*!
+ * @brief This internal API computes CRC-16/CCITT-FALSE over a buffer.
+ *
+ * @param[in] buf : Data.
+ * @param[in] len : Length of data.
+ *
+ * @return CRC
+ */
+static uint16_t crc16(const uint8_t *buf, uint32_t len);
+
+/*!
+ * @brief These internal APIs store and load little-endian 16-bit values.
+ */
+static void put_u16(uint8_t *buf, uint16_t val);
+static uint16_t get_u16(const uint8_t *buf);
+
+/*!
+ * @brief This internal API fires the alarm callback the first time the
+ * count held in the acquisition context reaches the alarm threshold.
+ *
+ * @param[in,out] rd : Acquisition context.
+ */
+static void alarm_check(lmt_read_t *rd);
 
 /*!
  * @brief Map a value from one scale to another. Used for lookup-table.
  */
 static double map(double val, double in_min, double in_max, double out_min, double out_max);
 
+/*
+ * @brief Timing used until a device is characterised
+ */
+static const lmt_timing_t default_timing = {
+    LMT_INIT_PERIOD_MS,
+    LMT_DRAIN_PERIOD_MS,
+    LMT_CAPTURE_PERIOD_MS,
+    LMT_CAPTURE_PERIOD_MS,
+    0,
+    0
+    };
+
 /*
  * @brief Look-up table used for converting no of pulses to *C
  */
@@ -101,151 +357,1836 @@ static const int16_t lut[21][2] = {
   * @retval lmt_status_t
   */
 lmt_status_t lmt_init(const lmt01_dev_t *dev)
+{
+    /* The probe keeps the state up to date */
+    return lmt_probe(dev);
+}
+
+/**
+  * @brief  Initialise lmt01 device without an acquisition.
+  * 
+  * @param[in] dev : LMT01 device structure
+  * 
+  * @return result of API execution status
+  * @retval lmt_status_t
+  */
+lmt_status_t lmt_init_lazy(const lmt01_dev_t *dev)
 {
     /* Check for null pointer in the device structure */
-    if(null_ptr_check(dev) != LMT_OK)
+    if(null_ptr_check(dev) != LMT_OK || dev->state == NULL)
         return LMT_E_NULL_PTR;
 
-    /* Count number of pulses received over 60ms period */
-    uint32_t pulses = count_pulses_ms(dev, 60);
-
-    if(pulses == 0)
-        return LMT_E_DEV_NOT_FOUND;
+    /* Already answered (e.g. characterised): nothing left to check */
+    if(!(dev->state->flags & LMT_STATE_PRESENT))
+        dev->state->flags |= LMT_STATE_LAZY;
 
     return LMT_OK;
 }
 
 /**
-  * @brief Obtain one temperature reading from device by counting pulses.
+  * @brief  Report whether a device has answered.
   * 
-  * @param[in] dev : LMT01 device structure.
-  * @param[out] pulses : Pointer to variable to store pulse count.
+  * @param[in] dev : LMT01 device structure
+  * 
+  * @return result of API execution status
+  * @retval LMT_OK if present, LMT_BUSY if the check is still pending
+  */
+lmt_status_t lmt_presence(const lmt01_dev_t *dev)
+{
+    if(dev == NULL || dev->state == NULL)
+        return LMT_E_NULL_PTR;
+
+    if(dev->state->flags & LMT_STATE_PRESENT)
+        return LMT_OK;
+
+    if(dev->state->flags & LMT_STATE_LAZY)
+        return LMT_BUSY;
+
+    return LMT_E_DEV_NOT_FOUND;
+}
+
+/**
+  * @brief  Initialise several lmt01 devices, probing them all at once.
+  * 
+  * @param[in] devs : LMT01 device structures
+  * @param[in] n : Number of devices
+  * @param[out] rslts : Per-device status (may be NULL)
   * 
   * @return result of API execution status
   * @retval lmt_status_t
   */
-lmt_status_t lmt_get_pulse_count(const lmt01_dev_t *dev, uint32_t *pulses)
+lmt_status_t lmt_init_multi(const lmt01_dev_t *const *devs, uint32_t n, lmt_status_t *rslts)
 {
-    /* Check for null pointer in the device structure */
-    if(null_ptr_check(dev) != LMT_OK)
+    lmt_status_t rslt = LMT_OK;
+    uint32_t pending = n;
+    uint32_t window = 0;
+    uint32_t elapsed;
+    uint32_t i;
+
+    if(devs == NULL || n == 0)
         return LMT_E_NULL_PTR;
 
-    /* If pulses are received over next 10ms period, we are in
-        the middle of an output. Wait until output has finished. */
-    while(count_pulses_ms(dev, 10) != 0);
+    for(i = 0; i < n; i++)
+    {
+        if(null_ptr_check(devs[i]) != LMT_OK)
+            return LMT_E_NULL_PTR;
 
-    /* Expect to receive a reading over the next ~104ms,
-       begin counting pulses. */
-    uint32_t pulse_count = count_pulses_ms(dev, 104);
+        /* Wait as long as the slowest device needs */
+        if(timing_of(devs[i])->init_ms > window)
+            window = timing_of(devs[i])->init_ms;
+    }
 
-    /* Error: did not receive any pulses, device unresponsive? */
-    if(pulse_count == 0)
+    /* Start every counter, then poll them together. A device has
+       answered once its count is non-zero. */
+    for(i = 0; i < n; i++)
+        window_open(devs[i]);
+
+    for(elapsed = 0; elapsed < window && pending != 0; elapsed += LMT_PROBE_POLL_MS)
     {
-        return LMT_E_DEV_NOT_FOUND;
+        sleep_ms(devs[0], LMT_PROBE_POLL_MS);
+        pending = 0;
+
+        for(i = 0; i < n; i++)
+        {
+            if(timer_get(devs[i], devs[i]->timer) == 0)
+                pending++;
+        }
     }
 
-    *pulses = pulse_count;
+    for(i = 0; i < n; i++)
+    {
+        lmt_status_t dev_rslt = (window_close(devs[i]) != 0) ? LMT_OK : LMT_E_DEV_NOT_FOUND;
+
+        state_update(devs[i], dev_rslt);
 
-    return LMT_OK;
+        if(rslts != NULL)
+            rslts[i] = dev_rslt;
+
+        if(dev_rslt != LMT_OK && rslt == LMT_OK)
+            rslt = dev_rslt;
+    }
+
+    return rslt;
 }
 
 /**
-  * @brief  Obtains a pulse count reading from the LMT device
-  *         and converts this value to temperature equivalent
-  *         according to the type parameter.
+  * @brief  Check that a device is alive, returning on the first pulse.
   * 
-  * @param[in] lmt : LMT Handle
-  * @param[out] temp : Temperature reading
-  * @param[in] type : Conversion type (EQU, LUT)
+  * @param[in] dev : LMT01 device structure
   * 
-  * @return Result of API execution status
+  * @return result of API execution status
   * @retval lmt_status_t
   */
-lmt_status_t lmt_get_temperature(const lmt01_dev_t *dev, float *temp, lmt_conv_t type)
+lmt_status_t lmt_probe(const lmt01_dev_t *dev)
+{
+    const lmt01_dev_t *devs[1];
+
+    /* Check for null pointer in the device structure */
+    if(null_ptr_check(dev) != LMT_OK)
+        return LMT_E_NULL_PTR;
+
+    devs[0] = dev;
+
+    return lmt_init_multi(devs, 1, NULL);
+}
+
+/**
+  * @brief Obtain one temperature reading from device by counting pulses.
+  * 
+  * @param[in] dev : LMT01 device structure.
+  * @param[out] pulses : Pointer to variable to store pulse count.
+  * 
+  * @return result of API execution status
+  * @retval lmt_status_t
+  */
+lmt_status_t lmt_get_pulse_count(const lmt01_dev_t *dev, uint32_t *pulses)
 {
     lmt_status_t rslt;
-    uint32_t pulses;
+    lmt_read_t rd = {0};
 
-    /* Obtain temperature reading from device in pulse form */
-    rslt = lmt_get_pulse_count(dev, &pulses);
+    rslt = lmt_read_wait(dev, &rd);
 
     if(rslt != LMT_OK)
         return rslt;
 
-    /* Convert reading to temperature */
-    *temp = lmt_pulses_to_temperature(pulses, type);
+    *pulses = rd.pulses;
 
     return LMT_OK;
 }
 
 /**
-  * @brief  Converts a pulse count to temperature equivalent
-  *         according to the type parameter.
+  * @brief  Read several devices together.
   * 
-  * @param[in] pulses : Number of pulses
-  * @param[in] type   : Conversion type (EQU, LUT)
+  * @param[in] devs : LMT01 device structures
+  * @param[in] n : Number of devices
+  * @param[out] pulses : Per-device pulse count
+  * @param[out] rslts : Per-device status
   * 
-  * @return Result of pulses -> temperature conversion
-  * @retval temp
+  * @return result of API execution status
+  * @retval lmt_status_t
   */
-float lmt_pulses_to_temperature(uint32_t pulses, lmt_conv_t type)
+lmt_status_t lmt_get_pulse_count_multi(const lmt01_dev_t *const *devs, uint32_t n,
+                                       uint32_t *pulses, lmt_status_t *rslts)
 {
-    if (pulses == 0)
-        return -1;
+    lmt_status_t rslt = LMT_OK;
+    uint32_t pending = n;
+    uint32_t drain = 0, period = 0;
+    uint32_t now = 0, next, due;
+    uint32_t i, cnt;
+    uint8_t redrain;
 
-    float temp = 0.0;
+    if(devs == NULL || pulses == NULL || rslts == NULL || n == 0)
+        return LMT_E_NULL_PTR;
 
-    /* Conversion method: Equation */
-    if (type == CONV_TYPE_EQU)
+    for(i = 0; i < n; i++)
     {
-        temp = ((pulses / 4096.0) * 256.0) - 50.0;
+        if(null_ptr_check(devs[i]) != LMT_OK)
+            return LMT_E_NULL_PTR;
+
+        if(timing_of(devs[i])->drain_ms > drain)
+            drain = timing_of(devs[i])->drain_ms;
+
+        if(timing_of(devs[i])->period_ms > period)
+            period = timing_of(devs[i])->period_ms;
     }
-    /* Conversion method: Lookup table */
-    else if (type == CONV_TYPE_LUT)
+
+    meter_begin(devs[0]);
+
+    /* While rslts[i] is LMT_BUSY, pulses[i] holds the time its capture
+       window opened, or UINT32_MAX while the device is still draining.
+       Draining devices share one window ending at due. */
+    for(i = 0; i < n; i++)
     {
-        size_t i;
-        for (i = 0; i < LEN(lut); i++)
-        {
-            if (pulses >= lut[i][1] && pulses <= lut[i + 1][1])
-                break;
-        }
-        
-        /* Map number of pulses to degress celcius using lookup table */
-        temp = map(pulses, lut[i][1], lut[i + 1][1], lut[i][0], lut[i + 1][0]);
+        rslts[i] = LMT_BUSY;
+        pulses[i] = UINT32_MAX;
+        window_open(devs[i]);
     }
 
-    return temp;
-}
+    due = drain;
 
-/*!
- * @brief This internal API is used to count the number of pulses
- * received in a given period (ms).
- */
-static uint32_t count_pulses_ms(const lmt01_dev_t *dev, uint32_t period)
-{
-    uint32_t cnt = 0;
-    
-    /* Stop counting pulses */
-    dev->stop_timer(dev->timer);
+    while(pending != 0)
+    {
+        /* Sleep until the first window ends */
+        next = due;
 
-    /* Reset the timer pulse count */
-    dev->set_timer_cnt(dev->timer, &cnt);
+        for(i = 0; i < n; i++)
+        {
+            if(rslts[i] == LMT_BUSY && pulses[i] != UINT32_MAX &&
+               pulses[i] + timing_of(devs[i])->capture_ms < next)
+                next = pulses[i] + timing_of(devs[i])->capture_ms;
+        }
 
-    /* Start counting pulses */
-    dev->start_timer(dev->timer);
+        sleep_ms(devs[0], next - now);
+        now = next;
+        redrain = 0;
 
-    /* Wait until period elapses */
-    dev->delay_ms(period);
+        for(i = 0; i < n; i++)
+        {
+            if(rslts[i] != LMT_BUSY)
+                continue;
+
+            if(pulses[i] == UINT32_MAX)
+            {
+                if(now != due)
+                    continue;
+
+                /* Quiet: start capturing, otherwise keep draining. Not
+                   quiet in a whole sensor cycle: give up on it below. */
+                cnt = window_close(devs[i]);
+
+                if(cnt == 0 || now <= period)
+                {
+                    window_open(devs[i]);
+
+                    if(cnt == 0)
+                        pulses[i] = now;
+                    else
+                        redrain = 1;
+
+                    continue;
+                }
+
+                rslts[i] = LMT_E_TIMEOUT;
+                cnt = 0;
+            }
+            else if(now - pulses[i] < timing_of(devs[i])->capture_ms)
+            {
+                continue;
+            }
+            else
+            {
+                cnt = window_close(devs[i]);
+                rslts[i] = (cnt != 0) ? LMT_OK : LMT_E_DEV_NOT_FOUND;
+            }
+
+            pulses[i] = cnt;
+            pending--;
+
+            state_update(devs[i], rslts[i]);
+
+            if(cnt != 0 && devs[i]->state != NULL)
+                devs[i]->state->last_pulses = cnt;
+
+            if(rslts[i] != LMT_OK && rslt == LMT_OK)
+                rslt = rslts[i];
+        }
+
+        if(now == due)
+            due = redrain ? now + drain : UINT32_MAX;
+    }
+
+    meter_end(devs[0]);
+
+    return rslt;
+}
+
+/**
+  * @brief  Power-cycle several devices together.
+  * 
+  * @param[in] devs : LMT01 device structures
+  * @param[in] n : Number of devices
+  * 
+  * @return result of API execution status
+  * @retval lmt_status_t
+  */
+lmt_status_t lmt_power_cycle(const lmt01_dev_t *const *devs, uint32_t n)
+{
+    uint32_t i;
+
+    if(devs == NULL || n == 0)
+        return LMT_E_NULL_PTR;
+
+    for(i = 0; i < n; i++)
+    {
+        if(null_ptr_check(devs[i]) != LMT_OK || devs[i]->set_power == NULL)
+            return LMT_E_NULL_PTR;
+    }
+
+    for(i = 0; i < n; i++)
+        power_set(devs[i], 0);
+
+    sleep_ms(devs[0], LMT_POWER_OFF_MS);
+
+    /* Back-to-back so the conversions start together */
+    for(i = 0; i < n; i++)
+        power_set(devs[i], 1);
+
+    return LMT_OK;
+}
+
+/**
+  * @brief  Switch the sensor supply through set_power.
+  * 
+  * @param[in] dev : LMT01 device structure
+  * @param[in] on : Non-zero to power the sensor
+  * 
+  * @return result of API execution status
+  * @retval lmt_status_t
+  */
+lmt_status_t lmt_set_power(const lmt01_dev_t *dev, uint8_t on)
+{
+    if(null_ptr_check(dev) != LMT_OK || dev->set_power == NULL)
+        return LMT_E_NULL_PTR;
+
+    power_set(dev, on);
+
+    return LMT_OK;
+}
+
+/**
+  * @brief  Read a synchronised group in one capture window.
+  * 
+  * @param[in] devs : LMT01 device structures
+  * @param[in] n : Number of devices
+  * @param[in,out] sync : Group context.
+  * @param[out] pulses : Per-device pulse count
+  * @param[out] rslts : Per-device status
+  * 
+  * @return result of API execution status
+  * @retval lmt_status_t
+  */
+lmt_status_t lmt_sync_read(const lmt01_dev_t *const *devs, uint32_t n, lmt_sync_t *sync,
+                           uint32_t *pulses, lmt_status_t *rslts)
+{
+    lmt_status_t rslt = LMT_OK;
+    uint32_t drain = 0, window = 0, period = 0;
+    uint32_t elapsed, total, last_total = 0, steady = 0;
+    uint32_t first, last, limit;
+    uint32_t pending, i, cnt;
+    uint8_t fresh = 0;
+
+    if(devs == NULL || n == 0 || sync == NULL || pulses == NULL || rslts == NULL)
+        return LMT_E_NULL_PTR;
+
+    for(i = 0; i < n; i++)
+    {
+        if(null_ptr_check(devs[i]) != LMT_OK)
+            return LMT_E_NULL_PTR;
+
+        if(timing_of(devs[i])->drain_ms > drain)
+            drain = timing_of(devs[i])->drain_ms;
+
+        if(timing_of(devs[i])->capture_ms > window)
+            window = timing_of(devs[i])->capture_ms;
+
+        if(timing_of(devs[i])->period_ms > period)
+            period = timing_of(devs[i])->period_ms;
+    }
+
+    meter_begin(devs[0]);
+
+    if(!sync->synced)
+    {
+        rslt = lmt_power_cycle(devs, n);
+
+        if(rslt != LMT_OK)
+        {
+            sync_fail(devs, n, pulses, rslts, rslt);
+            return rslt;
+        }
+
+        sync->synced = 1;
+        sync->resyncs++;
+        fresh = 1;
+    }
+
+    /* Just powered up: converting, no burst under way. Otherwise drain
+       the group together until every device is quiet. Never quiet: a
+       stuck or foreign signal, resynchronise on the next call. */
+    if(!fresh && drain_quiet(devs, n, drain, period) != LMT_OK)
+    {
+        sync->synced = 0;
+        sync_fail(devs, n, pulses, rslts, LMT_E_TIMEOUT);
+        return LMT_E_TIMEOUT;
+    }
+
+    for(i = 0; i < n; i++)
+        window_open(devs[i]);
+
+    /* One window for the group. pulses[i] holds the time of the first
+       pulse until the window closes, UINT32_MAX while none is seen. */
+    for(i = 0; i < n; i++)
+        pulses[i] = UINT32_MAX;
+
+    pending = n;
+
+    for(elapsed = LMT_PROBE_POLL_MS; elapsed <= window; elapsed += LMT_PROBE_POLL_MS)
+    {
+        sleep_ms(devs[0], LMT_PROBE_POLL_MS);
+        total = 0;
+
+        for(i = 0; i < n; i++)
+        {
+            cnt = timer_get(devs[i], devs[i]->timer);
+            total += cnt;
+
+            if(cnt != 0 && pulses[i] == UINT32_MAX)
+            {
+                pulses[i] = elapsed;
+                pending--;
+            }
+        }
+
+        /* Every burst has ended */
+        steady = (total == last_total) ? steady + LMT_PROBE_POLL_MS : 0;
+        last_total = total;
+
+        if(pending == 0 && steady > LMT_GAP_MS)
+            break;
+    }
+
+    first = UINT32_MAX;
+    last = 0;
+
+    for(i = 0; i < n; i++)
+    {
+        if(pulses[i] != UINT32_MAX)
+        {
+            if(pulses[i] < first)
+                first = pulses[i];
+
+            if(pulses[i] > last)
+                last = pulses[i];
+        }
+
+        cnt = window_close(devs[i]);
+        rslts[i] = (cnt != 0) ? LMT_OK : LMT_E_DEV_NOT_FOUND;
+        pulses[i] = cnt;
+
+        state_update(devs[i], rslts[i]);
+
+        if(cnt != 0 && devs[i]->state != NULL)
+            devs[i]->state->last_pulses = cnt;
+
+        if(rslts[i] != LMT_OK && rslt == LMT_OK)
+            rslt = rslts[i];
+    }
+
+    /* Drifted apart: line the group up again for the next read */
+    sync->skew_ms = (first != UINT32_MAX) ? last - first : 0;
+    limit = (sync->max_skew_ms != 0) ? sync->max_skew_ms : LMT_SYNC_SKEW_MS;
+
+    if(sync->skew_ms > limit && lmt_power_cycle(devs, n) == LMT_OK)
+        sync->resyncs++;
+
+    meter_end(devs[0]);
+
+    return rslt;
+}
+
+/**
+  * @brief  Begin a non-blocking pulse count reading.
+  * 
+  * @param[in] dev : LMT01 device structure.
+  * @param[in,out] rd : Acquisition context, options filled in.
+  * 
+  * @return result of API execution status
+  * @retval LMT_BUSY while the reading is in progress
+  */
+lmt_status_t lmt_read_start(const lmt01_dev_t *dev, lmt_read_t *rd)
+{
+    /* Check for null pointer in the device structure */
+    if(rd == NULL || null_ptr_check(dev) != LMT_OK)
+        return LMT_E_NULL_PTR;
+
+    meter_begin(dev);
+
+    rd->dev = dev;
+    rd->pulses = 0;
+    rd->elapsed_ms = 0;
+    rd->alarm_fired = 0;
+    rd->sig_c0 = rd->sig_c1 = rd->sig_cp = 0;
+    rd->sig_t0 = rd->sig_t1 = rd->sig_tp = 0;
+
+    /* If pulses are received over next 10ms period, we are in
+        the middle of an output. Wait until output has finished. */
+    rd->state = LMT_READ_DRAIN;
+    rd->wait_ms = timing_of(dev)->drain_ms;
+    rd->rslt = LMT_BUSY;
+
+    window_open(dev);
+    meter_wait(rd);
+
+    return rd->rslt;
+}
+
+/**
+  * @brief  Advance a non-blocking reading once rd->wait_ms has elapsed.
+  * 
+  * @param[in,out] rd : Acquisition context.
+  * 
+  * @return result of API execution status
+  * @retval LMT_BUSY while in progress, otherwise final status
+  */
+lmt_status_t lmt_read_step(lmt_read_t *rd)
+{
+    const lmt01_dev_t *dev;
+    const lmt_timing_t *timing;
+    uint32_t poll, cnt;
+
+    if(rd == NULL || rd->dev == NULL)
+        return LMT_E_NULL_PTR;
+
+    /* Finished: report the result again. Never started: nothing to do. */
+    if(rd->state == LMT_READ_DONE)
+        return rd->rslt;
+
+    if(rd->state != LMT_READ_DRAIN && rd->state != LMT_READ_CAPTURE)
+        return LMT_E_INVALID;
+
+    dev = rd->dev;
+    timing = timing_of(dev);
+    poll = poll_of(rd);
+
+    switch(rd->state)
+    {
+        case LMT_READ_DRAIN:
+            cnt = window_close(dev);
+
+            /* Still mid-output, keep draining. Not quiet in a whole
+               sensor cycle: a stuck or foreign signal. */
+            if(cnt != 0)
+            {
+                rd->elapsed_ms += timing->drain_ms;
+
+                if(rd->elapsed_ms > timing->period_ms)
+                {
+                    rd->state = LMT_READ_DONE;
+                    rd->wait_ms = 0;
+                    rd->rslt = LMT_E_TIMEOUT;
+                    meter_end(dev);
+                    state_update(dev, rd->rslt);
+                    break;
+                }
+
+                rd->wait_ms = timing->drain_ms;
+                window_open(dev);
+                break;
+            }
+
+            /* Expect to receive a reading over the next ~104ms,
+               begin counting pulses. */
+            rd->state = LMT_READ_CAPTURE;
+            rd->elapsed_ms = 0;
+            rd->wait_ms = timing->capture_ms;
+
+            if(poll != 0 && poll < rd->wait_ms)
+                rd->wait_ms = poll;
+
+            window_open(dev);
+
+            /* Let hardware flag the end of the burst */
+            if(has_gap_timer(dev))
+            {
+                dev->arm_gap_timer(dev->timer, LMT_GAP_MS);
+                hal_count(dev, 1);
+            }
+            break;
+
+        case LMT_READ_CAPTURE:
+            rd->elapsed_ms += rd->wait_ms;
+
+            /* Mid-window poll: sample the running count, the counter
+               keeps counting. Finish early once the burst has ended. */
+            if(rd->elapsed_ms < timing->capture_ms &&
+               !gap_ended(dev))
+            {
+                cnt = timer_get(dev, dev->timer);
+                rd->pulses = cnt;
+                alarm_check(rd);
+                signature_sample(rd, cnt);
+
+                rd->wait_ms = timing->capture_ms - rd->elapsed_ms;
+
+                if(poll < rd->wait_ms)
+                    rd->wait_ms = poll;
+                break;
+            }
+
+            capture_end(rd);
+            break;
+
+        default:
+            break;
+    }
+
+    meter_wait(rd);
+
+    return rd->rslt;
+}
+
+/**
+  * @brief  Finish a non-blocking reading from the gap timer interrupt.
+  * 
+  * @param[in,out] rd : Acquisition context.
+  * 
+  * @return result of API execution status
+  * @retval LMT_BUSY if the reading is not at the end of its burst yet,
+  *         otherwise as lmt_read_step()
+  */
+lmt_status_t lmt_read_gap_irq(lmt_read_t *rd)
+{
+    if(rd == NULL || rd->dev == NULL)
+        return LMT_E_NULL_PTR;
+
+    /* Only the capture waits for the gap timer. A late or stray
+       interrupt leaves the reading alone. */
+    if(rd->state != LMT_READ_CAPTURE || !gap_ended(rd->dev))
+        return (rd->state == LMT_READ_IDLE) ? LMT_E_INVALID : rd->rslt;
+
+    capture_end(rd);
+
+    return rd->rslt;
+}
+
+/**
+  * @brief  Run a reading to completion, waiting with the device delay_ms.
+  * 
+  * @param[in] dev : LMT01 device structure.
+  * @param[in,out] rd : Acquisition context, options filled in.
+  * 
+  * @return result of API execution status
+  * @retval lmt_status_t
+  */
+lmt_status_t lmt_read_wait(const lmt01_dev_t *dev, lmt_read_t *rd)
+{
+    lmt_status_t rslt;
+
+    if(rd == NULL)
+        return LMT_E_NULL_PTR;
+
+    /* Drive the non-blocking engine, waiting in place between steps */
+    rd->blocking = 1;
+    rslt = lmt_read_start(dev, rd);
+
+    while(rslt == LMT_BUSY)
+    {
+        /* The capture wait is only a timeout once the gap timer is armed:
+           it ends the wait as soon as the burst has ended */
+        if(rd->state == LMT_READ_CAPTURE && has_gap_timer(dev))
+            rd->wait_ms = gap_wait(dev, rd->wait_ms);
+        else
+            sleep_ms(dev, rd->wait_ms);
+
+        rslt = lmt_read_step(rd);
+    }
+
+    rd->blocking = 0;
+
+    return rslt;
+}
+
+/**
+  * @brief  Start continuous acquisition on timer and timer_b.
+  * 
+  * @param[in] dev : LMT01 device structure, timer_b set.
+  * @param[in,out] st : Streaming context, options filled in.
+  * 
+  * @return result of API execution status
+  * @retval lmt_status_t
+  */
+lmt_status_t lmt_stream_start(const lmt01_dev_t *dev, lmt_stream_t *st)
+{
+    lmt_status_t rslt;
+    uint32_t cnt = 0;
+
+    /* Check for null pointer in the device structure */
+    if(st == NULL || null_ptr_check(dev) != LMT_OK || !has_timer_b(dev))
+        return LMT_E_NULL_PTR;
+
+    if(st->period_ms == 0)
+        st->period_ms = timing_of(dev)->capture_ms;
+
+    /* Park the second timer at zero */
+    timer_stop(dev, dev->timer_b);
+    timer_set(dev, dev->timer_b, cnt);
+
+    /* Wait for the gap between bursts */
+    rslt = drain_quiet(&dev, 1, timing_of(dev)->drain_ms, timing_of(dev)->period_ms);
+
+    if(rslt != LMT_OK)
+        return rslt;
+
+    /* First timer counts the next period */
+    st->active = 0;
+    window_open(dev);
+
+    return LMT_OK;
+}
+
+/**
+  * @brief  Wait for the next period and return its pulse count.
+  * 
+  * @param[in] dev : LMT01 device structure, timer_b set.
+  * @param[in,out] st : Streaming context.
+  * @param[out] pulses : Pulses counted over the period.
+  * 
+  * @return result of API execution status
+  * @retval lmt_status_t
+  */
+lmt_status_t lmt_stream_next(const lmt01_dev_t *dev, lmt_stream_t *st, uint32_t *pulses)
+{
+    lmt_status_t rslt = LMT_OK;
+    uint32_t prev, held = 0, cnt = 0;
+
+    /* Check for null pointer in the device structure */
+    if(st == NULL || pulses == NULL || null_ptr_check(dev) != LMT_OK || !has_timer_b(dev))
+        return LMT_E_NULL_PTR;
+
+    void *active = stream_timer(dev, st->active);
+    void *idle = stream_timer(dev, !st->active);
+
+    meter_begin(dev);
+
+    /* Run to 1ms before the end of the period */
+    sleep_ms(dev, st->period_ms > 1 ? st->period_ms - 1 : 0);
+
+    /* Hold the switch until the line is quiet. If the sensor period has
+       drifted against ours this slips the switch back into the gap.
+       Still pulsing after a whole sensor cycle: not bursts, switch
+       anyway so the stream goes on. */
+    cnt = timer_get(dev, active);
+    do
+    {
+        prev = cnt;
+        sleep_ms(dev, 1);
+        cnt = timer_get(dev, active);
+
+        if(++held > timing_of(dev)->period_ms)
+        {
+            rslt = LMT_E_TIMEOUT;
+            break;
+        }
+    } while(cnt != prev);
+
+    /* Idle timer takes over before the active one stops */
+    timer_start(dev, idle);
+    timer_stop(dev, active);
+    cnt = timer_get(dev, active);
+
+    *pulses = cnt;
+
+    /* Reset the stopped timer, ready for the next switch */
+    cnt = 0;
+    timer_set(dev, active, cnt);
+    st->active = !st->active;
+    meter_end(dev);
+
+    if(*pulses == 0)
+        return LMT_E_DEV_NOT_FOUND;
+
+    return rslt;
+}
+
+/**
+  * @brief  Start periodic sampling.
+  * 
+  * @param[in] dev : LMT01 device structure.
+  * @param[in,out] pd : Periodic context, options filled in.
+  * 
+  * @return result of API execution status
+  * @retval lmt_status_t
+  */
+lmt_status_t lmt_periodic_start(const lmt01_dev_t *dev, lmt_periodic_t *pd)
+{
+    lmt_status_t rslt;
+    uint32_t limit, cnt, first_us, cycles;
+
+    /* Check for null pointer in the device structure */
+    if(pd == NULL || null_ptr_check(dev) != LMT_OK || dev->get_time_us == NULL)
+        return LMT_E_NULL_PTR;
+
+    limit = 2 * (uint32_t)timing_of(dev)->capture_ms;
+
+    rslt = drain_quiet(&dev, 1, timing_of(dev)->drain_ms, timing_of(dev)->period_ms);
+
+    if(rslt != LMT_OK)
+        return rslt;
+
+    /* Time two burst starts, one output cycle apart */
+    window_open(dev);
+    rslt = burst_end(dev, limit, &cnt, &first_us);
+
+    if(rslt == LMT_OK)
+    {
+        window_open(dev);
+        rslt = burst_end(dev, limit, &cnt, &pd->grid_us);
+    }
+
+    window_close(dev);
+
+    if(rslt != LMT_OK)
+        return rslt;
+
+    pd->cycle_us = pd->grid_us - first_us;
+    cycles = (pd->period_ms * 1000 + pd->cycle_us / 2) / pd->cycle_us;
+    pd->period_us = ((cycles != 0) ? cycles : 1) * pd->cycle_us;
+    pd->samples = 0;
+    pd->skipped = 0;
+    pd->jitter_us = 0;
+    pd->max_jitter_us = 0;
+
+    return LMT_OK;
+}
+
+/**
+  * @brief  Wait for the next grid point and read the burst nearest to it.
+  * 
+  * @param[in] dev : LMT01 device structure.
+  * @param[in,out] pd : Periodic context.
+  * @param[out] pulses : Pulse count.
+  * 
+  * @return result of API execution status
+  * @retval lmt_status_t
+  */
+lmt_status_t lmt_periodic_next(const lmt01_dev_t *dev, lmt_periodic_t *pd, uint32_t *pulses)
+{
+    lmt_status_t rslt;
+    uint32_t grid, open, start_us, now;
+
+    /* Check for null pointer in the device structure */
+    if(pd == NULL || pulses == NULL || null_ptr_check(dev) != LMT_OK || dev->get_time_us == NULL)
+        return LMT_E_NULL_PTR;
+
+    if(pd->cycle_us == 0)
+        return LMT_E_INVALID;
+
+    meter_begin(dev);
+
+    /* Listen from half a cycle before the grid point, so exactly one
+       burst starts in the window. Too late for that: next point. */
+    grid = pd->grid_us + pd->period_us;
+    now = time_us(dev);
+
+    while((int32_t)(now - (grid - pd->cycle_us / 2)) > 0)
+    {
+        grid += pd->period_us;
+        pd->skipped++;
+    }
+
+    open = grid - pd->cycle_us / 2;
+    sleep_ms(dev, (open - now) / 1000);
+
+    rslt = drain_quiet(&dev, 1, timing_of(dev)->drain_ms, timing_of(dev)->period_ms);
+
+    if(rslt == LMT_OK)
+    {
+        window_open(dev);
+        rslt = burst_end(dev, pd->cycle_us / 1000 + LMT_TIMING_MARGIN_MS, pulses, &start_us);
+        window_close(dev);
+    }
+
+    /* The grid moves on even without a sample */
+    pd->grid_us = grid;
+    state_update(dev, rslt);
+    meter_end(dev);
+
+    if(rslt != LMT_OK)
+        return rslt;
+
+    if(dev->state != NULL)
+        dev->state->last_pulses = *pulses;
+
+    pd->samples++;
+    pd->jitter_us = (int32_t)(start_us - grid);
+
+    if((uint32_t)((pd->jitter_us < 0) ? -pd->jitter_us : pd->jitter_us) > pd->max_jitter_us)
+        pd->max_jitter_us = (uint32_t)((pd->jitter_us < 0) ? -pd->jitter_us : pd->jitter_us);
+
+    return LMT_OK;
+}
+
+/**
+  * @brief  Measure the sensor and derive its acquisition windows.
+  * 
+  * @param[in] dev : LMT01 device structure.
+  * @param[out] timing : Measured timing (may be NULL).
+  * 
+  * @return result of API execution status
+  * @retval lmt_status_t
+  */
+lmt_status_t lmt_characterise(const lmt01_dev_t *dev, lmt_timing_t *timing)
+{
+    lmt_timing_t t = default_timing;
+    uint32_t prev = 0, cnt, pulses = 0;
+    uint32_t start = 0, end = 0, now, gap;
+    uint8_t phase = 0;
+
+    /* Check for null pointer in the device structure */
+    if(null_ptr_check(dev) != LMT_OK)
+        return LMT_E_NULL_PTR;
+
+    /* Start from a gap, with the default drain window. The period is
+       not known yet: allow the longest one that can be characterised. */
+    if(drain_quiet(&dev, 1, t.drain_ms, LMT_TIMING_MAX_MS) != LMT_OK)
+        return LMT_E_TIMEOUT;
+
+    window_open(dev);
+
+    /* Poll the running count: 0 = waiting for a burst, 1 = in the burst,
+       2 = waiting for the next one to start */
+    for(now = LMT_PROBE_POLL_MS; now <= 3 * LMT_CAPTURE_PERIOD_MS && phase < 3; now += LMT_PROBE_POLL_MS)
+    {
+        sleep_ms(dev, LMT_PROBE_POLL_MS);
+        cnt = timer_get(dev, dev->timer);
+
+        if(phase == 0 && cnt != 0)
+        {
+            start = end = now;
+            phase = 1;
+        }
+        else if(phase == 1 && cnt != prev)
+        {
+            end = now;
+        }
+        else if(phase == 1 && now - end > LMT_GAP_MS)
+        {
+            pulses = cnt;
+            phase = 2;
+        }
+        else if(phase == 2 && cnt != pulses)
+        {
+            t.period_ms = (uint16_t)(now - start);
+            phase = 3;
+        }
+
+        prev = cnt;
+    }
+
+    window_close(dev);
+
+    if(phase == 0)
+        return LMT_E_DEV_NOT_FOUND;
+
+    if(phase != 3)
+        return LMT_E_TIMEOUT;
+
+    /* A burst shorter than the poll interval still took some time */
+    t.burst_ms = (uint16_t)((end > start) ? end - start : LMT_PROBE_POLL_MS);
+    t.freq_hz = pulses * 1000 / t.burst_ms;
+
+    if(t.burst_ms >= t.period_ms)
+        return LMT_E_TIMEOUT;
+
+    gap = t.period_ms - t.burst_ms;
+
+    /* Period and burst are only known to a poll interval either way.
+       A capture opens after a quiet drain window, at least drain_ms
+       past the end of a burst, so it holds the next burst whole if it
+       is longer than period - drain_ms. It must end before the burst
+       after that, so it is kept shorter than the period. The drain is
+       the margin plus the measuring error, but at most half the gap,
+       so the line can be seen quiet. */
+    t.drain_ms = clamp_ms(LMT_TIMING_MARGIN_MS + 2 * LMT_PROBE_POLL_MS);
+
+    if(t.drain_ms > gap / 2)
+        t.drain_ms = clamp_ms(gap / 2);
+
+    t.capture_ms = clamp_ms(t.period_ms + 2 * LMT_PROBE_POLL_MS - t.drain_ms);
+
+    /* Any window longer than the gap sees part of a burst */
+    t.init_ms = clamp_ms(gap + LMT_TIMING_MARGIN_MS);
+
+    if(timing != NULL)
+        *timing = t;
+
+    if(dev->state != NULL)
+    {
+        dev->state->timing = t;
+        dev->state->flags |= LMT_STATE_TIMED | LMT_STATE_PRESENT;
+    }
+
+    return LMT_OK;
+}
+
+/**
+  * @brief  Serialise device state.
+  * 
+  * @param[in] state : Device state.
+  * @param[out] buf : Destination.
+  * @param[in] len : Size of buf, at least LMT_STATE_BLOB_LEN.
+  * 
+  * @return result of API execution status
+  * @retval lmt_status_t
+  */
+lmt_status_t lmt_state_save(const lmt_state_t *state, uint8_t *buf, uint32_t len)
+{
+    if(state == NULL || buf == NULL)
+        return LMT_E_NULL_PTR;
+
+    if(len < LMT_STATE_BLOB_LEN)
+        return LMT_E_INVALID;
+
+    /* Little-endian, CRC last */
+    buf[0] = LMT_STATE_VERSION;
+    buf[1] = state->flags;
+    put_u16(&buf[2], (uint16_t)state->last_pulses);
+    put_u16(&buf[4], (uint16_t)(state->last_pulses >> 16));
+    put_u16(&buf[6], state->timing.init_ms);
+    put_u16(&buf[8], state->timing.drain_ms);
+    put_u16(&buf[10], state->timing.capture_ms);
+    put_u16(&buf[12], state->timing.period_ms);
+    put_u16(&buf[14], state->timing.burst_ms);
+    put_u16(&buf[16], (uint16_t)state->timing.freq_hz);
+    put_u16(&buf[18], (uint16_t)(state->timing.freq_hz >> 16));
+
+    uint16_t crc = crc16(buf, LMT_STATE_BLOB_LEN - 2);
+
+    put_u16(&buf[LMT_STATE_BLOB_LEN - 2], crc);
+
+    return LMT_OK;
+}
+
+/**
+  * @brief  Restore device state saved by lmt_state_save().
+  * 
+  * @param[out] state : Device state, unchanged on failure.
+  * @param[in] buf : Source.
+  * @param[in] len : Size of buf.
+  * 
+  * @return result of API execution status
+  * @retval lmt_status_t
+  */
+lmt_status_t lmt_state_restore(lmt_state_t *state, const uint8_t *buf, uint32_t len)
+{
+    if(state == NULL || buf == NULL)
+        return LMT_E_NULL_PTR;
+
+    if(len < LMT_STATE_BLOB_LEN || buf[0] != LMT_STATE_VERSION)
+        return LMT_E_INVALID;
+
+    if(get_u16(&buf[LMT_STATE_BLOB_LEN - 2]) != crc16(buf, LMT_STATE_BLOB_LEN - 2))
+        return LMT_E_INVALID;
+
+    state->flags = buf[1];
+    state->last_pulses = get_u16(&buf[2]) | ((uint32_t)get_u16(&buf[4]) << 16);
+    state->timing.init_ms = get_u16(&buf[6]);
+    state->timing.drain_ms = get_u16(&buf[8]);
+    state->timing.capture_ms = get_u16(&buf[10]);
+    state->timing.period_ms = get_u16(&buf[12]);
+    state->timing.burst_ms = get_u16(&buf[14]);
+    state->timing.freq_hz = get_u16(&buf[16]) | ((uint32_t)get_u16(&buf[18]) << 16);
+
+    /* Windows that would miss or split a burst: use the defaults */
+    if((state->flags & LMT_STATE_TIMED) && !timing_valid(&state->timing))
+        state->flags &= (uint8_t)~LMT_STATE_TIMED;
+
+    return LMT_OK;
+}
+
+/**
+  * @brief  Obtains a pulse count reading from the LMT device
+  *         and converts this value to temperature equivalent
+  *         according to the type parameter.
+  * 
+  * @param[in] lmt : LMT Handle
+  * @param[out] temp : Temperature reading
+  * @param[in] type : Conversion type (EQU, LUT)
+  * 
+  * @return Result of API execution status
+  * @retval lmt_status_t
+  */
+lmt_status_t lmt_get_temperature(const lmt01_dev_t *dev, float *temp, lmt_conv_t type)
+{
+    lmt_status_t rslt;
+    uint32_t pulses;
+
+    /* Obtain temperature reading from device in pulse form */
+    rslt = lmt_get_pulse_count(dev, &pulses);
+
+    if(rslt != LMT_OK)
+        return rslt;
+
+    /* Convert reading to temperature */
+    *temp = lmt_pulses_to_temperature(pulses, type);
+
+    return LMT_OK;
+}
+
+/**
+  * @brief  Converts a pulse count to temperature equivalent
+  *         according to the type parameter. Counts outside the table
+  *         are extrapolated from its end segments.
+  * 
+  * @param[in] pulses : Number of pulses
+  * @param[in] type   : Conversion type (EQU, LUT)
+  * 
+  * @return Result of pulses -> temperature conversion, -1 for 0 pulses.
+  *         EQU also gives -1 for 784 pulses, so test the count, not
+  *         the result, for a missing reading.
+  * @retval temp
+  */
+float lmt_pulses_to_temperature(uint32_t pulses, lmt_conv_t type)
+{
+    if (pulses == 0)
+        return -1;
+
+    float temp = 0.0;
+
+    /* Conversion method: Equation */
+    if (type == CONV_TYPE_EQU)
+    {
+        temp = ((pulses / 4096.0) * 256.0) - 50.0;
+    }
+    /* Conversion method: Lookup table */
+    else if (type == CONV_TYPE_LUT)
+    {
+        /* Find the segment containing pulses. Counts outside the table
+           (e.g. a partial count mid-burst) use the end segments. */
+        size_t i;
+        for (i = 0; i < LEN(lut) - 2; i++)
+        {
+            if (pulses <= (uint32_t)lut[i + 1][1])
+                break;
+        }
+        
+        /* Map number of pulses to degress celcius using lookup table */
+        temp = map(pulses, lut[i][1], lut[i + 1][1], lut[i][0], lut[i + 1][0]);
+    }
+
+    return temp;
+}
+
+/**
+  * @brief  Converts the count of a reading in progress or completed to
+  *         temperature. While capturing this is a lower bound, as the
+  *         count only grows until the burst ends.
+  * 
+  * @param[in] rd : Acquisition context.
+  * @param[out] temp : Temperature, at least LMT_TEMP_MIN_C while provisional
+  * @param[in] type : Conversion type (EQU, LUT)
+  * 
+  * @return Result of API execution status
+  * @retval LMT_BUSY if temp is provisional, LMT_OK if final
+  */
+lmt_status_t lmt_read_temperature(const lmt_read_t *rd, float *temp, lmt_conv_t type)
+{
+    if(rd == NULL || temp == NULL)
+        return LMT_E_NULL_PTR;
+
+    if(rd->rslt != LMT_OK && rd->rslt != LMT_BUSY)
+        return rd->rslt;
+
+    /* No pulses yet: bound by the sensor range, not the -1 sentinel */
+    if(rd->rslt == LMT_BUSY && rd->pulses == 0)
+    {
+        *temp = LMT_TEMP_MIN_C;
+        return LMT_BUSY;
+    }
+
+    *temp = lmt_pulses_to_temperature(rd->pulses, type);
+
+    /* LUT extrapolates below the range for the first few pulses */
+    if(rd->rslt == LMT_BUSY && *temp < LMT_TEMP_MIN_C)
+        *temp = LMT_TEMP_MIN_C;
+
+    return rd->rslt;
+}
+
+/**
+  * @brief  Converts a temperature to the smallest pulse count that
+  *         represents at least that temperature (inverse of EQU).
+  * 
+  * @param[in] temp : Temperature (*C)
+  * 
+  * @return Pulse count, 1 at or below LMT_TEMP_MIN_C, UINT32_MAX for NaN
+  *         or beyond any count
+  * @retval pulses
+  */
+uint32_t lmt_temperature_to_pulses(float temp)
+{
+    /* NaN is never reached */
+    if (temp != temp)
+        return UINT32_MAX;
+
+    /* Below the sensor range every reading is over threshold */
+    if (temp <= LMT_TEMP_MIN_C)
+        return 1;
+
+    /* Inverse of ((pulses / 4096) * 256) - 50, rounded up */
+    double pulses = (temp + 50.0) * (4096.0 / 256.0);
+
+    /* Beyond any count (+inf included): never reached */
+    if (pulses >= (double)UINT32_MAX)
+        return UINT32_MAX;
+
+    uint32_t p = (uint32_t)pulses;
+
+    if ((double)p < pulses)
+        p++;
+
+    return p;
+}
+
+/*!
+ * @brief This internal API waits until a group is quiet for a drain window.
+ */
+static lmt_status_t drain_quiet(const lmt01_dev_t *const *devs, uint32_t n,
+                                uint32_t drain_ms, uint32_t limit_ms)
+{
+    uint32_t drained = 0, pending, i;
+
+    for(;;)
+    {
+        pending = 0;
+
+        for(i = 0; i < n; i++)
+            window_open(devs[i]);
+
+        /* Wait until period elapses */
+        sleep_ms(devs[0], drain_ms);
+
+        for(i = 0; i < n; i++)
+        {
+            if(window_close(devs[i]) != 0)
+                pending++;
+        }
+
+        if(pending == 0)
+            return LMT_OK;
+
+        /* Bursts leave a gap every sensor cycle. Still pulsing after one:
+           a stuck or foreign signal. */
+        drained += drain_ms;
+
+        if(drained > limit_ms)
+            return LMT_E_TIMEOUT;
+    }
+}
+
+/*!
+ * @brief This internal API starts a timer counting.
+ */
+static inline void timer_start(const lmt01_dev_t *dev, void *timer)
+{
+    if (dev->en_reg != NULL && timer == dev->timer)
+        *dev->en_reg |= dev->en_mask;
+    else
+    {
+        dev->start_timer(timer);
+        hal_count(dev, 1);
+    }
+}
+
+/*!
+ * @brief This internal API stops a timer counting.
+ */
+static inline void timer_stop(const lmt01_dev_t *dev, void *timer)
+{
+    if (dev->en_reg != NULL && timer == dev->timer)
+        *dev->en_reg &= ~dev->en_mask;
+    else
+    {
+        dev->stop_timer(timer);
+        hal_count(dev, 1);
+    }
+}
+
+/*!
+ * @brief This internal API sets a timer count.
+ */
+static inline void timer_set(const lmt01_dev_t *dev, void *timer, uint32_t cnt)
+{
+    if (dev->cnt_reg != NULL && timer == dev->timer)
+        *dev->cnt_reg = cnt;
+    else
+    {
+        dev->set_timer_cnt(timer, &cnt);
+        hal_count(dev, 1);
+    }
+}
+
+/*!
+ * @brief This internal API reads a timer count.
+ */
+static inline uint32_t timer_get(const lmt01_dev_t *dev, void *timer)
+{
+    uint32_t cnt;
+
+    if (dev->cnt_reg != NULL && timer == dev->timer)
+        cnt = *dev->cnt_reg;
+    else
+    {
+        dev->get_timer_cnt(timer, &cnt);
+        hal_count(dev, 1);
+    }
+
+    return cnt;
+}
+
+/*!
+ * @brief This internal API resets the pulse counter and starts counting.
+ */
+static void window_open(const lmt01_dev_t *dev)
+{
+    uint32_t cnt = 0;
+    
+    /* Stop counting pulses */
+    timer_stop(dev, dev->timer);
+
+    /* Reset the timer pulse count */
+    timer_set(dev, dev->timer, cnt);
+
+    /* Start counting pulses */
+    timer_start(dev, dev->timer);
+}
+
+/*!
+ * @brief This internal API stops counting and returns the pulses counted.
+ */
+static uint32_t window_close(const lmt01_dev_t *dev)
+{
+    uint32_t cnt = 0;
 
     /* Stop counting pulses */
-    dev->stop_timer(dev->timer);
+    timer_stop(dev, dev->timer);
 
     /* Get the number of pulses counted */
-    dev->get_timer_cnt(dev->timer, &cnt);
+    cnt = timer_get(dev, dev->timer);
 
     return cnt;
 }
 
+/*!
+ * @brief This internal API returns the timer context for a ping-pong slot.
+ */
+static void *stream_timer(const lmt01_dev_t *dev, uint8_t slot)
+{
+    return slot ? dev->timer_b : dev->timer;
+}
+
+/*!
+ * @brief This internal API checks for the gap timer hooks.
+ */
+static uint8_t has_gap_timer(const lmt01_dev_t *dev)
+{
+    return (dev->arm_gap_timer != NULL) && (dev->gap_expired != NULL);
+}
+
+/*!
+ * @brief This internal API checks whether the gap timer has expired.
+ */
+static uint8_t gap_ended(const lmt01_dev_t *dev)
+{
+    if(!has_gap_timer(dev))
+        return 0;
+
+    hal_count(dev, 1);
+
+    return dev->gap_expired(dev->timer) != 0;
+}
+
+/*!
+ * @brief This internal API waits for the gap timer, up to limit_ms.
+ */
+static uint32_t gap_wait(const lmt01_dev_t *dev, uint32_t limit_ms)
+{
+    uint32_t start, now, deadline;
+    uint32_t waited = 0;
+
+    /* delay_ms cannot be cut short. The MCU is awake anyway, so watch
+       the gap timer in small steps. */
+    if(dev->sleep_until == NULL || dev->get_time_us == NULL)
+    {
+        while(waited < limit_ms && !gap_ended(dev))
+        {
+            sleep_ms(dev, LMT_PROBE_POLL_MS);
+            waited += LMT_PROBE_POLL_MS;
+        }
+
+        return waited;
+    }
+
+    /* One sleep to the end of the window, which the gap timer interrupt
+       cuts short. Woken early by something else: sleep on. */
+    start = time_us(dev);
+    deadline = start + limit_ms * 1000;
+
+    do
+    {
+        dev->sleep_until(dev->timer, deadline);
+        hal_count(dev, 1);
+        now = time_us(dev);
+    } while((int32_t)(deadline - now) > 0 && !gap_ended(dev));
+
+    if(dev->energy != NULL)
+        dev->energy->run_sleep_us += now - start;
+
+    return (now - start + 999) / 1000;
+}
+
+/*!
+ * @brief This internal API closes the capture window of a reading.
+ */
+static void capture_end(lmt_read_t *rd)
+{
+    const lmt01_dev_t *dev = rd->dev;
+    uint32_t cnt = window_close(dev);
+
+    rd->state = LMT_READ_DONE;
+    rd->wait_ms = 0;
+    meter_end(dev);
+
+    /* Error: did not receive any pulses, device unresponsive? */
+    if(cnt == 0)
+    {
+        rd->rslt = LMT_E_DEV_NOT_FOUND;
+        state_update(dev, rd->rslt);
+        return;
+    }
+
+    rd->pulses = cnt;
+    rd->rslt = LMT_OK;
+    state_update(dev, rd->rslt);
+
+    if(dev->state != NULL)
+        dev->state->last_pulses = cnt;
+
+    alarm_check(rd);
+    health_update(rd);
+}
+
+/*!
+ * @brief This internal API checks that the second timer can be driven.
+ */
+static uint8_t has_timer_b(const lmt01_dev_t *dev)
+{
+    return (dev->timer_b != NULL) && (dev->start_timer != NULL) && (dev->stop_timer != NULL) &&
+           (dev->set_timer_cnt != NULL) && (dev->get_timer_cnt != NULL);
+}
+
+/*!
+ * @brief This internal API records the outcome in the device state.
+ */
+static void state_update(const lmt01_dev_t *dev, lmt_status_t rslt)
+{
+    if(dev->state == NULL)
+        return;
+
+    /* A lazy presence check is settled by the first outcome either way */
+    dev->state->flags &= (uint8_t)~LMT_STATE_LAZY;
+
+    if(rslt == LMT_OK)
+        dev->state->flags |= LMT_STATE_PRESENT;
+    else
+        dev->state->flags &= (uint8_t)~LMT_STATE_PRESENT;
+}
+
+/*!
+ * @brief This internal API returns the capture poll interval of a reading.
+ */
+static uint32_t poll_of(const lmt_read_t *rd)
+{
+    const lmt01_dev_t *dev = rd->dev;
+    uint32_t poll = 0;
+
+    if(rd->poll_ms != 0)
+        return rd->poll_ms;
+
+    /* An alarm is only early if the running count is sampled */
+    if(rd->alarm_cb != NULL && rd->alarm_pulses != 0)
+        poll = LMT_ALARM_POLL_MS;
+
+    if(dev->health != NULL && dev->get_time_us != NULL && (poll == 0 || LMT_HEALTH_POLL_MS < poll))
+        poll = LMT_HEALTH_POLL_MS;
+
+    return poll;
+}
+
+/*!
+ * @brief This internal API records a running count for the burst signature.
+ */
+static void signature_sample(lmt_read_t *rd, uint32_t cnt)
+{
+    const lmt01_dev_t *dev = rd->dev;
+
+    if(dev->health == NULL || dev->get_time_us == NULL)
+        return;
+
+    /* Still rising, so the previous sample was taken mid-burst */
+    if(rd->sig_cp != 0 && cnt > rd->sig_cp)
+    {
+        if(rd->sig_c0 == 0)
+        {
+            rd->sig_c0 = rd->sig_cp;
+            rd->sig_t0 = rd->sig_tp;
+        }
+        else
+        {
+            rd->sig_c1 = rd->sig_cp;
+            rd->sig_t1 = rd->sig_tp;
+        }
+    }
+
+    rd->sig_cp = cnt;
+    rd->sig_tp = time_us(dev);
+}
+
+/*!
+ * @brief This internal API checks the burst signature of a completed reading.
+ */
+static void health_update(const lmt_read_t *rd)
+{
+    lmt_health_t *health = rd->dev->health;
+    uint32_t nominal, tol, dt;
+    uint8_t pass;
+
+    /* Needs two mid-burst samples, a very short burst may not give them */
+    if(health == NULL || rd->sig_c1 <= rd->sig_c0)
+        return;
+
+    dt = rd->sig_t1 - rd->sig_t0;
+
+    if(dt == 0)
+        return;
+
+    nominal = (health->nominal_hz != 0) ? health->nominal_hz : LMT_NOMINAL_FREQ_HZ;
+    tol = (health->tol_pct != 0) ? health->tol_pct : LMT_HEALTH_TOL_PCT;
+
+    health->freq_hz = (uint32_t)((uint64_t)(rd->sig_c1 - rd->sig_c0) * 1000000 / dt);
+    health->burst_us = (uint32_t)((uint64_t)rd->pulses * 1000000 / health->freq_hz);
+
+    pass = (uint64_t)health->freq_hz * 100 >= (uint64_t)nominal * (100 - tol) &&
+           (uint64_t)health->freq_hz * 100 <= (uint64_t)nominal * (100 + tol);
+
+    /* Start healthy, then a running average over ~8 checks */
+    if(health->checks == 0)
+        health->score = 100;
+
+    if(pass)
+        health->score = (uint8_t)((health->score * 7 + 100 + 7) / 8);
+    else
+        health->score = (uint8_t)((health->score * 7) / 8);
+
+    health->checks++;
+
+    if(!pass)
+        health->faults++;
+
+    health->status = pass ? LMT_OK : LMT_E_SIGNATURE;
+}
+
+/*!
+ * @brief This internal API waits, sleeping if the device can.
+ */
+static void sleep_ms(const lmt01_dev_t *dev, uint32_t ms)
+{
+    if(dev->sleep_until != NULL && dev->get_time_us != NULL)
+    {
+        dev->sleep_until(dev->timer, time_us(dev) + ms * 1000);
+        hal_count(dev, 1);
+
+        if(dev->energy != NULL)
+            dev->energy->run_sleep_us += ms * 1000;
+    }
+    else
+    {
+        dev->delay_ms(ms);
+        hal_count(dev, 1);
+    }
+}
+
+/*!
+ * @brief This internal API counts HAL calls on the energy meter.
+ */
+static inline void hal_count(const lmt01_dev_t *dev, uint32_t calls)
+{
+    if(dev->energy != NULL)
+        dev->energy->run_calls += calls;
+}
+
+/*!
+ * @brief This internal API reads get_time_us, counted as a HAL call.
+ */
+static inline uint32_t time_us(const lmt01_dev_t *dev)
+{
+    hal_count(dev, 1);
+
+    return dev->get_time_us(dev->timer);
+}
+
+/*!
+ * @brief This internal API switches the sensor supply.
+ */
+static void power_set(const lmt01_dev_t *dev, uint8_t on)
+{
+    lmt_energy_t *meter = dev->energy;
+    uint32_t now;
+
+    dev->set_power(dev->timer, on);
+    hal_count(dev, 1);
+
+    /* Nothing to account, or no change */
+    if(meter == NULL || dev->get_time_us == NULL || (on == 0) == meter->unpowered)
+        return;
+
+    /* Bank the on time at switch-off, restart it at switch-on */
+    now = dev->get_time_us(dev->timer);
+
+    if(!on)
+        meter->power_acc_us += now - meter->power_us;
+
+    meter->power_us = now;
+    meter->unpowered = !on;
+}
+
+/*!
+ * @brief This internal API ends a group read that failed early.
+ */
+static void sync_fail(const lmt01_dev_t *const *devs, uint32_t n, uint32_t *pulses,
+                      lmt_status_t *rslts, lmt_status_t rslt)
+{
+    uint32_t i;
+
+    for(i = 0; i < n; i++)
+    {
+        pulses[i] = 0;
+        rslts[i] = rslt;
+    }
+
+    meter_end(devs[0]);
+}
+
+/*!
+ * @brief This internal API marks the start of a reading.
+ */
+static void meter_begin(const lmt01_dev_t *dev)
+{
+    lmt_energy_t *meter = dev->energy;
+
+    if(meter == NULL)
+        return;
+
+    meter->run_calls = 0;
+    meter->run_sleep_us = 0;
+
+    if(dev->get_time_us != NULL)
+        meter->start_us = dev->get_time_us(dev->timer);
+}
+
+/*!
+ * @brief This internal API charges the caller's wait as sleep.
+ */
+static void meter_wait(const lmt_read_t *rd)
+{
+    if(rd->rslt == LMT_BUSY && !rd->blocking && rd->dev->energy != NULL)
+        rd->dev->energy->run_sleep_us += rd->wait_ms * 1000;
+}
+
+/*!
+ * @brief This internal API latches the figures of a completed reading.
+ */
+static void meter_end(const lmt01_dev_t *dev)
+{
+    lmt_energy_t *meter = dev->energy;
+    uint32_t now;
+
+    if(meter == NULL)
+        return;
+
+    meter->hal_calls = meter->run_calls;
+    meter->sleep_us = meter->run_sleep_us;
+    meter->readings++;
+
+    if(dev->get_time_us == NULL)
+        return;
+
+    now = dev->get_time_us(dev->timer);
+    meter->read_us = now - meter->start_us;
+    meter->awake_us = (meter->read_us > meter->sleep_us) ? meter->read_us - meter->sleep_us : 0;
+
+    /* Supply time since the previous reading */
+    meter->sensor_us = meter->power_acc_us;
+
+    if(!meter->unpowered)
+        meter->sensor_us += now - meter->power_us;
+
+    meter->power_us = now;
+    meter->power_acc_us = 0;
+}
+
+/*!
+ * @brief This internal API waits for the end of the next burst.
+ */
+static lmt_status_t burst_end(const lmt01_dev_t *dev, uint32_t limit_ms, uint32_t *pulses, uint32_t *start_us)
+{
+    uint32_t elapsed, cnt, prev = 0, quiet = 0;
+
+    for(elapsed = LMT_PROBE_POLL_MS; elapsed <= limit_ms; elapsed += LMT_PROBE_POLL_MS)
+    {
+        sleep_ms(dev, LMT_PROBE_POLL_MS);
+        cnt = timer_get(dev, dev->timer);
+
+        if(cnt != prev)
+        {
+            if(prev == 0)
+                *start_us = time_us(dev);
+
+            quiet = 0;
+        }
+        else if(cnt != 0 && (quiet += LMT_PROBE_POLL_MS) > LMT_GAP_MS)
+        {
+            *pulses = cnt;
+            return LMT_OK;
+        }
+
+        prev = cnt;
+    }
+
+    return (prev == 0) ? LMT_E_DEV_NOT_FOUND : LMT_E_TIMEOUT;
+}
+
+/*!
+ * @brief This internal API returns the timing a device acquires with.
+ */
+static const lmt_timing_t *timing_of(const lmt01_dev_t *dev)
+{
+    if(dev->state != NULL && (dev->state->flags & LMT_STATE_TIMED))
+        return &dev->state->timing;
+
+    return &default_timing;
+}
+
+/*!
+ * @brief This internal API clamps a window to the characterisation limits.
+ */
+static uint16_t clamp_ms(uint32_t ms)
+{
+    if(ms < LMT_TIMING_MIN_MS)
+        return LMT_TIMING_MIN_MS;
+
+    return (uint16_t)((ms > LMT_TIMING_MAX_MS) ? LMT_TIMING_MAX_MS : ms);
+}
+
+/*!
+ * @brief This internal API checks characterised timing.
+ */
+static uint8_t timing_valid(const lmt_timing_t *t)
+{
+    uint32_t span = (uint32_t)t->drain_ms + t->capture_ms;
+
+    if(t->init_ms != clamp_ms(t->init_ms) || t->drain_ms != clamp_ms(t->drain_ms) ||
+       t->capture_ms != clamp_ms(t->capture_ms))
+        return 0;
+
+    if(t->burst_ms == 0 || t->burst_ms >= t->period_ms || t->freq_hz == 0)
+        return 0;
+
+    return (span > t->period_ms && span <= (uint32_t)t->period_ms + 2 * LMT_PROBE_POLL_MS);
+}
+
+/*!
+ * @brief This internal API stores a little-endian 16-bit value.
+ */
+static void put_u16(uint8_t *buf, uint16_t val)
+{
+    buf[0] = (uint8_t)val;
+    buf[1] = (uint8_t)(val >> 8);
+}
+
+/*!
+ * @brief This internal API loads a little-endian 16-bit value.
+ */
+static uint16_t get_u16(const uint8_t *buf)
+{
+    return (uint16_t)(buf[0] | (buf[1] << 8));
+}
+
+/*!
+ * @brief This internal API computes CRC-16/CCITT-FALSE.
+ */
+static uint16_t crc16(const uint8_t *buf, uint32_t len)
+{
+    uint16_t crc = 0xFFFF;
+    uint32_t i;
+    uint8_t b;
+
+    for(i = 0; i < len; i++)
+    {
+        crc ^= (uint16_t)(buf[i] << 8);
+
+        for(b = 0; b < 8; b++)
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+
+    return crc;
+}
+
+/*!
+ * @brief This internal API fires the alarm callback once the threshold is met.
+ */
+static void alarm_check(lmt_read_t *rd)
+{
+    if (rd->alarm_cb == NULL || rd->alarm_pulses == 0 || rd->alarm_fired)
+        return;
+
+    if (rd->pulses >= rd->alarm_pulses)
+    {
+        rd->alarm_fired = 1;
+        rd->alarm_cb(rd->alarm_ctx, rd->pulses);
+    }
+}
+
 /*!
  * @brief This internal API is used to validate the device structure pointer for
  * null conditions.
@@ -254,8 +2195,11 @@ static lmt_status_t null_ptr_check(const lmt01_dev_t *dev)
 {
     lmt_status_t rslt;
 
-    if ((dev == NULL) || (dev->start_timer == NULL) || (dev->stop_timer == NULL)  ||
-        (dev->set_timer_cnt == NULL) || (dev->get_timer_cnt == NULL) || (dev->delay_ms == NULL)) 
+    /* Callbacks are only required where no register pointer replaces them */
+    if ((dev == NULL) ||
+        (dev->delay_ms == NULL && ((dev->sleep_until == NULL) || (dev->get_time_us == NULL))) ||
+        (dev->en_reg == NULL && ((dev->start_timer == NULL) || (dev->stop_timer == NULL))) ||
+        (dev->cnt_reg == NULL && ((dev->set_timer_cnt == NULL) || (dev->get_timer_cnt == NULL)))) 
     {
         /* Device structure pointer is not valid */
         rslt = LMT_E_NULL_PTR;
@@ -41,6 +41,48 @@ extern "C" {
 
 #include <stdint.h>
 
+/*!
+ * @brief Acquisition windows (ms)
+ */
+#define LMT_INIT_PERIOD_MS      60  /* Presence check window */
+#define LMT_DRAIN_PERIOD_MS     10  /* Window used to wait out a burst in progress */
+#define LMT_CAPTURE_PERIOD_MS   104 /* Window guaranteed to contain one full burst */
+#define LMT_GAP_MS              1   /* Quiet time that marks the end of a burst */
+#define LMT_PROBE_POLL_MS       1   /* Poll interval of the presence probe */
+
+/*!
+ * @brief Characterised timing: safety margin and clamps (ms)
+ */
+#define LMT_TIMING_MARGIN_MS    2
+#define LMT_TIMING_MIN_MS       1
+#define LMT_TIMING_MAX_MS       250
+
+/*!
+ * @brief Burst signature defaults: nominal pulse frequency, tolerance
+ *        and capture poll interval used while checking it
+ */
+#define LMT_NOMINAL_FREQ_HZ     88000
+#define LMT_HEALTH_TOL_PCT      10
+#define LMT_HEALTH_POLL_MS      1
+
+/*!
+ * @brief Capture poll interval used when an alarm is set without poll_ms
+ */
+#define LMT_ALARM_POLL_MS       1
+
+/*!
+ * @brief Group power-cycle: time held off (ms) and default phase skew
+ *        limit before the group is re-synchronised (ms)
+ */
+#define LMT_POWER_OFF_MS        5
+#define LMT_SYNC_SKEW_MS        2
+
+/*!
+ * @brief Bottom of the sensor range (*C), the lower bound of a reading
+ *        before any pulses are counted
+ */
+#define LMT_TEMP_MIN_C          (-50.0f)
+
 /*!
   * @brief  Enum defining the different temperature conversion techniques.
   *         These are either by Equation, or by Lookup Table.
@@ -57,7 +99,11 @@ typedef enum {
     LMT_OK,
     LMT_E_NULL_PTR,
     LMT_E_DEV_NOT_FOUND,
-    LMT_E_TIMEOUT
+    LMT_E_TIMEOUT,
+    LMT_BUSY,
+    LMT_E_INVALID,
+    LMT_E_SIGNATURE,
+    LMT_E_NO_MEM
 } lmt_status_t;
 
 /*!
@@ -66,6 +112,135 @@ typedef enum {
 typedef void (*lmt_timer_mode_fptr_t)(void* timer);
 typedef void (*lmt_timer_cnt_fptr_t)(void* timer, uint32_t *cnt);
 typedef void (*lmt_delay_ms_fptr_t)(uint32_t ms);
+typedef void (*lmt_alarm_fptr_t)(void *ctx, uint32_t pulses);
+typedef void (*lmt_gap_arm_fptr_t)(void *timer, uint32_t gap_ms);
+typedef uint8_t (*lmt_gap_expired_fptr_t)(void *timer);
+typedef uint32_t (*lmt_time_us_fptr_t)(void *timer);
+typedef void (*lmt_power_fptr_t)(void *timer, uint8_t on);
+typedef void (*lmt_sleep_until_fptr_t)(void *timer, uint32_t wake_us);
+
+/*!
+ * @brief  Device state flags
+ */
+#define LMT_STATE_LAZY      (1 << 0)    /* Presence is checked by the first reading */
+#define LMT_STATE_PRESENT   (1 << 1)    /* Device has answered */
+#define LMT_STATE_TIMED     (1 << 2)    /* timing holds characterised values */
+
+/*!
+ * @brief  Serialised state format (see lmt_state_save)
+ */
+#define LMT_STATE_VERSION   2
+#define LMT_STATE_BLOB_LEN  22
+
+/*!
+ * @brief  Acquisition timing of one sensor. Defaults are the
+ *         LMT_*_PERIOD_MS values; lmt_characterise() measures the sensor
+ *         and derives tighter windows from it.
+ */
+typedef struct
+{
+    /* Presence check window (ms) */
+    uint16_t init_ms;
+
+    /* Drain window (ms) */
+    uint16_t drain_ms;
+
+    /* Capture window (ms) */
+    uint16_t capture_ms;
+
+    /* Measured output period, burst start to burst start (ms) */
+    uint16_t period_ms;
+
+    /* Measured burst duration (ms) */
+    uint16_t burst_ms;
+
+    /* Measured pulse frequency (Hz) */
+    uint32_t freq_hz;
+
+} lmt_timing_t;
+
+/*!
+ * @brief  Per-device state kept by the driver between calls
+ */
+typedef struct
+{
+    /* LMT_STATE_* flags */
+    uint8_t flags;
+
+    /* Pulse count of the last successful reading */
+    uint32_t last_pulses;
+
+    /* Acquisition timing, used when LMT_STATE_TIMED is set */
+    lmt_timing_t timing;
+
+} lmt_state_t;
+
+/*!
+ * @brief  Burst signature health of a device. The pulse frequency is
+ *         measured from the running count during each reading and
+ *         checked against nominal_hz; score tracks recent checks.
+ *         Zero-initialise, then set the options.
+ */
+typedef struct
+{
+    /* Option: expected pulse frequency (Hz), 0 for LMT_NOMINAL_FREQ_HZ */
+    uint32_t nominal_hz;
+
+    /* Option: allowed deviation (%), 0 for LMT_HEALTH_TOL_PCT */
+    uint8_t tol_pct;
+
+    /* Frequency measured by the last check (Hz) */
+    uint32_t freq_hz;
+
+    /* Burst duration implied by the last check (us) */
+    uint32_t burst_us;
+
+    /* 0 (failing) .. 100 (healthy), averaged over recent checks */
+    uint8_t score;
+
+    /* Result of the last check: LMT_OK or LMT_E_SIGNATURE */
+    lmt_status_t status;
+
+    /* Checks made, and how many failed */
+    uint32_t checks;
+    uint32_t faults;
+
+} lmt_health_t;
+
+/*!
+ * @brief  Energy meter, updated by every reading. Counts the HAL calls
+ *         and waits the driver makes and, with get_time_us, times the
+ *         reading and the sensor supply. Zero-initialise. The sensor is
+ *         taken as powered until lmt_set_power() switches it off.
+ */
+typedef struct
+{
+    /* Last reading: time from start to result (us), and of that the
+       time asleep (us) and the rest, awake (us). Asleep is the time in
+       sleep_until, and with the non-blocking API the wait_ms given to
+       the caller. delay_ms counts as awake. */
+    uint32_t read_us;
+    uint32_t sleep_us;
+    uint32_t awake_us;
+
+    /* Last reading: HAL calls made */
+    uint32_t hal_calls;
+
+    /* Sensor supply on time since the previous reading (us) */
+    uint32_t sensor_us;
+
+    /* Readings completed */
+    uint32_t readings;
+
+    /* Internal: counts since the reading started, sensor supply */
+    uint32_t run_calls;
+    uint32_t run_sleep_us;
+    uint32_t start_us;
+    uint32_t power_us;
+    uint32_t power_acc_us;
+    uint8_t unpowered;
+
+} lmt_energy_t;
 
 /*!
  * @brief  lmt01 device structure
@@ -90,8 +265,188 @@ typedef struct
     /* Delay (ms) function pointer */
     lmt_delay_ms_fptr_t delay_ms;    
 
+    /* Second timer context counting the same input (optional, streaming) */
+    void *timer_b;
+
+    /* Arm retriggerable one-shot: started by the next edge, restarted by
+       every edge, expires after gap_ms without one (optional) */
+    lmt_gap_arm_fptr_t arm_gap_timer;
+
+    /* Returns non-zero once the armed gap timer has expired (optional) */
+    lmt_gap_expired_fptr_t gap_expired;
+
+    /* Counter register of timer. When set, accessed directly in place of
+       set_timer_cnt/get_timer_cnt (optional) */
+    volatile uint32_t *cnt_reg;
+
+    /* Enable register of timer and its enable bit(s). When set, accessed
+       directly in place of start_timer/stop_timer (optional) */
+    volatile uint32_t *en_reg;
+    uint32_t en_mask;
+
+    /* Driver state, kept across calls (optional) */
+    lmt_state_t *state;
+
+    /* Free-running timestamp (us), may wrap (optional, health) */
+    lmt_time_us_fptr_t get_time_us;
+
+    /* Burst signature health, updated by every reading (optional,
+       needs get_time_us) */
+    lmt_health_t *health;
+
+    /* Switch the sensor supply (optional, power-cycling) */
+    lmt_power_fptr_t set_power;
+
+    /* Sleep until get_time_us reaches wake_us, the counter left running.
+       Used for every wait in place of delay_ms, which may then be NULL.
+       With the gap timer hooks set, it should also return once the gap
+       timer expires (its interrupt wakes the MCU): the capture is then
+       one sleep, ended by the burst (optional, needs get_time_us) */
+    lmt_sleep_until_fptr_t sleep_until;
+
+    /* Energy meter, updated by every reading (optional, times need
+       get_time_us). Group reads are charged to the first device, so
+       point every device of a group at the same meter. */
+    lmt_energy_t *energy;
+
 } lmt01_dev_t;
 
+/*!
+ * @brief  Non-blocking acquisition states
+ */
+typedef enum {
+    LMT_READ_IDLE,
+    LMT_READ_DRAIN,
+    LMT_READ_CAPTURE,
+    LMT_READ_DONE
+}   lmt_read_state_t;
+
+/*!
+ * @brief  Non-blocking acquisition context. One per reading in flight.
+ *         Zero-initialise before use; the option fields are read by
+ *         lmt_read_start() and left untouched.
+ */
+typedef struct
+{
+    /* Option: capture poll interval (ms), 0 to capture in one window */
+    uint32_t poll_ms;
+
+    /* Option: alarm threshold (pulses), 0 to disable. Checked on the
+       running count every poll_ms of the capture window, every
+       LMT_ALARM_POLL_MS if poll_ms is 0, and on the final count. The
+       tail of a burst being drained is not counted. */
+    uint32_t alarm_pulses;
+
+    /* Option: called once as soon as the count reaches alarm_pulses */
+    lmt_alarm_fptr_t alarm_cb;
+
+    /* Option: context passed to alarm_cb */
+    void *alarm_ctx;
+
+    /* Device being read */
+    const lmt01_dev_t *dev;
+
+    /* Current acquisition state */
+    lmt_read_state_t state;
+
+    /* Result of the last step */
+    lmt_status_t rslt;
+
+    /* Time (ms) the caller must wait before calling lmt_read_step() */
+    uint32_t wait_ms;
+
+    /* Pulse count, valid once the read has completed with LMT_OK.
+       While capturing with poll_ms set, holds the running count. */
+    uint32_t pulses;
+
+    /* Time (ms) spent in the capture window so far, or draining before it */
+    uint32_t elapsed_ms;
+
+    /* Set once alarm_cb has been called */
+    uint8_t alarm_fired;
+
+    /* Burst signature samples: first and last taken mid-burst, and
+       the previous one (count, us) */
+    uint32_t sig_c0, sig_t0;
+    uint32_t sig_c1, sig_t1;
+    uint32_t sig_cp, sig_tp;
+
+    /* Set while lmt_read_wait drives the reading, so the energy meter
+       does not take wait_ms as the caller's sleep */
+    uint8_t blocking;
+
+} lmt_read_t;
+
+/*!
+ * @brief  Ping-pong streaming context. Two timers on the same input take
+ *         turns counting, so no edge is lost while one is read and reset.
+ */
+typedef struct
+{
+    /* Option: sensor output period (ms), 0 for the device capture window */
+    uint32_t period_ms;
+
+    /* Timer currently counting: 0 = timer, 1 = timer_b */
+    uint8_t active;
+
+} lmt_stream_t;
+
+/*!
+ * @brief  Synchronised group context. The sensors of a group are
+ *         power-cycled together so their bursts arrive in lock step and
+ *         one capture window reads them all. Zero-initialise, then set
+ *         the options.
+ */
+typedef struct
+{
+    /* Option: largest first-pulse skew (ms) before re-synchronising,
+       0 for LMT_SYNC_SKEW_MS */
+    uint32_t max_skew_ms;
+
+    /* First-pulse skew measured by the last read (ms) */
+    uint32_t skew_ms;
+
+    /* Power cycles made */
+    uint32_t resyncs;
+
+    /* Group has been power-cycled */
+    uint8_t synced;
+
+} lmt_sync_t;
+
+/*!
+ * @brief  Periodic sampling context. Samples sit on a grid of absolute
+ *         times, phase-locked to the sensor's output at start, so the
+ *         period does not drift with the acquisition time.
+ */
+typedef struct
+{
+    /* Option: sampling period (ms), rounded to whole sensor output
+       cycles, 0 for every cycle */
+    uint32_t period_ms;
+
+    /* Sensor output cycle measured at start (us) */
+    uint32_t cycle_us;
+
+    /* Sampling period in use (us) */
+    uint32_t period_us;
+
+    /* Grid time of the last sample (us, get_time_us clock) */
+    uint32_t grid_us;
+
+    /* Samples taken */
+    uint32_t samples;
+
+    /* Grid points passed over because the caller was late */
+    uint32_t skipped;
+
+    /* Start of the last sample's burst relative to grid_us (us) */
+    int32_t jitter_us;
+
+    /* Largest |jitter_us| so far (us) */
+    uint32_t max_jitter_us;
+
+} lmt_periodic_t;
 
 /**
   * @brief  Initialise lmt01 device and check if alive.
@@ -103,6 +458,61 @@ typedef struct
   */
 lmt_status_t lmt_init(const lmt01_dev_t *dev);
 
+/**
+  * @brief  Initialise lmt01 device without an acquisition. The first
+  *         reading doubles as the presence check, returning
+  *         LMT_E_DEV_NOT_FOUND as lmt_init would, and settles
+  *         LMT_STATE_LAZY into LMT_STATE_PRESENT (see lmt_presence).
+  *         Other state flags are kept; a device already present stays
+  *         so. Requires dev->state.
+  * 
+  * @param[in] dev : LMT01 device structure
+  * 
+  * @return result of API execution status
+  * @retval lmt_status_t
+  */
+lmt_status_t lmt_init_lazy(const lmt01_dev_t *dev);
+
+/**
+  * @brief  Report whether a device has answered: by lmt_init, the
+  *         first reading after lmt_init_lazy, or any later reading.
+  *         Requires dev->state.
+  * 
+  * @param[in] dev : LMT01 device structure
+  * 
+  * @return result of API execution status
+  * @retval LMT_OK if present, LMT_BUSY while a lazy check is pending,
+  *         LMT_E_DEV_NOT_FOUND if the last outcome was no answer
+  */
+lmt_status_t lmt_presence(const lmt01_dev_t *dev);
+
+/**
+  * @brief  Initialise several lmt01 devices, probing them all at once.
+  *         Takes as long as the slowest device rather than the sum.
+  *         Each device's state is updated as lmt_init does.
+  *         The first device's delay_ms (or sleep_until) is used to wait.
+  * 
+  * @param[in] devs : LMT01 device structures
+  * @param[in] n : Number of devices
+  * @param[out] rslts : Per-device status (may be NULL)
+  * 
+  * @return result of API execution status
+  * @retval LMT_OK if every device was found, else the first failure
+  */
+lmt_status_t lmt_init_multi(const lmt01_dev_t *const *devs, uint32_t n, lmt_status_t *rslts);
+
+/**
+  * @brief  Check that a device is alive. Returns as soon as the first
+  *         pulse is seen; only waits the full presence window if
+  *         none arrives.
+  * 
+  * @param[in] dev : LMT01 device structure
+  * 
+  * @return result of API execution status
+  * @retval lmt_status_t
+  */
+lmt_status_t lmt_probe(const lmt01_dev_t *dev);
+
 /**
   * @brief  Obtains a pulse count reading from the LMT device
   *         and converts this value to temperature equivalent
@@ -129,18 +539,296 @@ lmt_status_t lmt_get_temperature(const lmt01_dev_t *dev, float *temp, lmt_conv_t
   */
 lmt_status_t lmt_get_pulse_count(const lmt01_dev_t *dev, uint32_t *pulses);
 
+/**
+  * @brief  Read several devices together. Each device's capture window
+  *         starts as soon as it is quiet, and all the windows share the
+  *         same wakeups. Takes as long as the slowest device rather than
+  *         the sum. The first device's delay_ms (or sleep_until) is used
+  *         to wait.
+  * 
+  * @param[in] devs : LMT01 device structures
+  * @param[in] n : Number of devices
+  * @param[out] pulses : Per-device pulse count
+  * @param[out] rslts : Per-device status
+  * 
+  * @return result of API execution status
+  * @retval LMT_OK if every device was read, else the first failure
+  */
+lmt_status_t lmt_get_pulse_count_multi(const lmt01_dev_t *const *devs, uint32_t n,
+                                       uint32_t *pulses, lmt_status_t *rslts);
+
+/**
+  * @brief  Power-cycle several devices together, so their conversions
+  *         start, and their bursts arrive, at the same time. Every device
+  *         needs set_power. The first device's delay_ms (or sleep_until)
+  *         is used to wait.
+  * 
+  * @param[in] devs : LMT01 device structures
+  * @param[in] n : Number of devices
+  * 
+  * @return result of API execution status
+  * @retval lmt_status_t
+  */
+lmt_status_t lmt_power_cycle(const lmt01_dev_t *const *devs, uint32_t n);
+
+/**
+  * @brief  Switch the sensor supply through set_power, so the energy
+  *         meter sees it.
+  * 
+  * @param[in] dev : LMT01 device structure
+  * @param[in] on : Non-zero to power the sensor
+  * 
+  * @return result of API execution status
+  * @retval lmt_status_t
+  */
+lmt_status_t lmt_set_power(const lmt01_dev_t *dev, uint8_t on);
+
+/**
+  * @brief  Read a synchronised group in one capture window. Powers the
+  *         group up together on first use. Each device's first pulse is
+  *         timed, and if they are further apart than max_skew_ms the
+  *         group is power-cycled again after the read. The window ends
+  *         once every device has answered and the counts are steady.
+  *         A group that never goes quiet for a drain window within a
+  *         sensor cycle gives LMT_E_TIMEOUT and is resynchronised on the
+  *         next call.
+  * 
+  * @param[in] devs : LMT01 device structures
+  * @param[in] n : Number of devices
+  * @param[in,out] sync : Group context.
+  * @param[out] pulses : Per-device pulse count
+  * @param[out] rslts : Per-device status
+  * 
+  * @return result of API execution status
+  * @retval LMT_OK if every device was read, else the first failure
+  *         (also in every rslts[] entry if the read failed before its
+  *         capture window)
+  */
+lmt_status_t lmt_sync_read(const lmt01_dev_t *const *devs, uint32_t n, lmt_sync_t *sync,
+                           uint32_t *pulses, lmt_status_t *rslts);
+
+/**
+  * @brief  Begin a non-blocking pulse count reading. The device delay_ms
+  *         function is not used; instead the caller waits rd->wait_ms
+  *         (e.g. on a timer event) before each call to lmt_read_step().
+  * 
+  * @param[in] dev : LMT01 device structure.
+  * @param[in,out] rd : Acquisition context, options filled in.
+  * 
+  * @return result of API execution status
+  * @retval LMT_BUSY while the reading is in progress
+  */
+lmt_status_t lmt_read_start(const lmt01_dev_t *dev, lmt_read_t *rd);
+
+/**
+  * @brief  Advance a non-blocking reading once rd->wait_ms has elapsed.
+  *         With the gap timer hooks set, the capture wait is a timeout;
+  *         lmt_read_gap_irq() ends it as soon as the gap timer expires.
+  * 
+  * @param[in,out] rd : Acquisition context.
+  * 
+  * @return result of API execution status
+  * @retval LMT_BUSY while in progress, LMT_OK with rd->pulses valid,
+  *         or an error as returned by lmt_get_pulse_count(). Once
+  *         finished, the final status again. LMT_E_NULL_PTR without a
+  *         device, LMT_E_INVALID if lmt_read_start() was not called.
+  */
+lmt_status_t lmt_read_step(lmt_read_t *rd);
+
+/**
+  * @brief  Finish a non-blocking reading from the gap timer interrupt.
+  *         Call it from the handler of the timer armed by arm_gap_timer.
+  *         If the reading is capturing and gap_expired confirms the end
+  *         of the burst, the window is closed and the result reported as
+  *         by lmt_read_step(). Otherwise nothing is done, so a stray or
+  *         late interrupt is harmless. The caller's pending wait for
+  *         rd->wait_ms can then be dropped.
+  * 
+  * @param[in,out] rd : Acquisition context.
+  * 
+  * @return result of API execution status
+  * @retval LMT_BUSY while in progress, otherwise the final status
+  */
+lmt_status_t lmt_read_gap_irq(lmt_read_t *rd);
+
+/**
+  * @brief  Run a reading to completion, waiting with the device delay_ms
+  *         (or sleep_until). Use this for blocking reads with options
+  *         (e.g. alarm) set.
+  * 
+  * @param[in] dev : LMT01 device structure.
+  * @param[in,out] rd : Acquisition context, options filled in.
+  * 
+  * @return result of API execution status
+  * @retval lmt_status_t
+  */
+lmt_status_t lmt_read_wait(const lmt01_dev_t *dev, lmt_read_t *rd);
+
+/**
+  * @brief  Start continuous acquisition on timer and timer_b. Waits for
+  *         the gap between bursts, then starts the first timer counting.
+  * 
+  * @param[in] dev : LMT01 device structure, timer_b set.
+  * @param[in,out] st : Streaming context, options filled in.
+  * 
+  * @return result of API execution status
+  * @retval lmt_status_t
+  */
+lmt_status_t lmt_stream_start(const lmt01_dev_t *dev, lmt_stream_t *st);
+
+/**
+  * @brief  Wait for the next period and return its pulse count. The idle
+  *         timer is started before the active one is stopped, and the
+  *         switch is held until the line is quiet, so it always falls in
+  *         the gap between bursts. The hold lasts at most one sensor
+  *         period: if the line is still not quiet, the timers switch
+  *         anyway and the count, which may split a burst, comes with
+  *         LMT_E_TIMEOUT.
+  * 
+  * @param[in] dev : LMT01 device structure, timer_b set.
+  * @param[in,out] st : Streaming context.
+  * @param[out] pulses : Pulses counted over the period.
+  * 
+  * @return result of API execution status
+  * @retval LMT_OK, LMT_E_DEV_NOT_FOUND without pulses, LMT_E_TIMEOUT if
+  *         the line never went quiet
+  */
+lmt_status_t lmt_stream_next(const lmt01_dev_t *dev, lmt_stream_t *st, uint32_t *pulses);
+
+/**
+  * @brief  Start periodic sampling. Times two bursts to measure the
+  *         sensor's output cycle, and puts the grid origin at the start
+  *         of the second. Needs get_time_us.
+  * 
+  * @param[in] dev : LMT01 device structure.
+  * @param[in,out] pd : Periodic context, options filled in.
+  * 
+  * @return result of API execution status
+  * @retval lmt_status_t
+  */
+lmt_status_t lmt_periodic_start(const lmt01_dev_t *dev, lmt_periodic_t *pd);
+
+/**
+  * @brief  Wait for the next grid point and read the burst starting
+  *         nearest to it. Sleeps against absolute time, so a slow
+  *         caller or a slow reading does not shift later samples. Grid
+  *         points that have already passed are skipped. pd->grid_us is
+  *         the sample's time; pd->jitter_us says how far from it the
+  *         burst actually started, at the LMT_PROBE_POLL_MS resolution.
+  *         The start is used as the end of a burst moves with its pulse
+  *         count.
+  * 
+  * @param[in] dev : LMT01 device structure.
+  * @param[in,out] pd : Periodic context.
+  * @param[out] pulses : Pulse count.
+  * 
+  * @return result of API execution status
+  * @retval lmt_status_t
+  */
+lmt_status_t lmt_periodic_next(const lmt01_dev_t *dev, lmt_periodic_t *pd, uint32_t *pulses);
+
+/**
+  * @brief  Measure the sensor's output period, burst duration and pulse
+  *         frequency, and derive the acquisition windows from them:
+  *         drain is LMT_TIMING_MARGIN_MS plus the measuring error (at
+  *         most half the gap between bursts), capture is shorter than
+  *         the period so it never reaches the burst after next, and the
+  *         presence check spans the gap. All are clamped to
+  *         LMT_TIMING_MIN_MS .. LMT_TIMING_MAX_MS. Takes up to three
+  *         output periods. If the
+  *         device has a state, the result is stored there and used by
+  *         every later acquisition.
+  *         Measurements are made by polling every LMT_PROBE_POLL_MS and
+  *         have that resolution.
+  * 
+  * @param[in] dev : LMT01 device structure.
+  * @param[out] timing : Measured timing (may be NULL).
+  * 
+  * @return result of API execution status
+  * @retval LMT_E_TIMEOUT if two bursts were not seen in time
+  */
+lmt_status_t lmt_characterise(const lmt01_dev_t *dev, lmt_timing_t *timing);
+
+/**
+  * @brief  Serialise device state, e.g. to retained RAM or a flash page
+  *         before a reset. The blob carries a version and a CRC.
+  *         It holds the flags, last reading and timing only. The burst
+  *         phase is left out: it is relative to get_time_us, which a
+  *         reset restarts, and the drain finds the next burst anyway.
+  *         Health is left out too: it lives in the caller's lmt_health_t,
+  *         which has no pointers and can sit in retained RAM as it is.
+  * 
+  * @param[in] state : Device state.
+  * @param[out] buf : Destination.
+  * @param[in] len : Size of buf, at least LMT_STATE_BLOB_LEN.
+  * 
+  * @return result of API execution status
+  * @retval lmt_status_t
+  */
+lmt_status_t lmt_state_save(const lmt_state_t *state, uint8_t *buf, uint32_t len);
+
+/**
+  * @brief  Restore device state saved by lmt_state_save(). A restored
+  *         device that was present needs no lmt_init before reading.
+  *         Timing that lmt_characterise() could not have produced (a
+  *         window out of range, or drain and capture that would miss or
+  *         split a burst) is dropped: LMT_STATE_TIMED is cleared and the
+  *         default windows are used.
+  * 
+  * @param[out] state : Device state, unchanged on failure.
+  * @param[in] buf : Source.
+  * @param[in] len : Size of buf.
+  * 
+  * @return result of API execution status
+  * @retval LMT_E_INVALID if the blob is corrupt or of another version
+  */
+lmt_status_t lmt_state_restore(lmt_state_t *state, const uint8_t *buf, uint32_t len);
+
 /**
   * @brief  Converts a pulse count to temperature equivalent
-  *         according to the type parameter.
+  *         according to the type parameter. Counts outside the table
+  *         are extrapolated from its end segments.
   * 
   * @param[in] pulses : Number of pulses
   * @param[in] type   : Conversion type (EQU, LUT)
   * 
-  * @return Result of pulses -> temperature conversion
+  * @return Result of pulses -> temperature conversion, -1 for 0 pulses.
+  *         EQU also gives -1 for 784 pulses, so test the count, not
+  *         the result, for a missing reading.
   * @retval temp
   */
 float lmt_pulses_to_temperature(uint32_t pulses, lmt_conv_t type);
 
+/**
+  * @brief  Converts the count of a reading in progress or completed to
+  *         temperature. While capturing with poll_ms set this is a lower
+  *         bound, as the count only grows until the burst ends. It is
+  *         never below LMT_TEMP_MIN_C, which is also the bound while
+  *         draining or before the first pulse.
+  * 
+  * @param[in] rd : Acquisition context.
+  * @param[out] temp : Temperature
+  * @param[in] type : Conversion type (EQU, LUT)
+  * 
+  * @return Result of API execution status
+  * @retval LMT_BUSY if temp is provisional, LMT_OK if final
+  */
+lmt_status_t lmt_read_temperature(const lmt_read_t *rd, float *temp, lmt_conv_t type);
+
+/**
+  * @brief  Converts a temperature to the smallest pulse count that
+  *         represents at least that temperature (inverse of EQU).
+  *         Used to derive alarm thresholds. At or below LMT_TEMP_MIN_C
+  *         every reading qualifies; NaN, or a temperature no 32-bit count
+  *         reaches, gives UINT32_MAX, a threshold that is never reached.
+  * 
+  * @param[in] temp : Temperature (*C)
+  * 
+  * @return Pulse count, 1 to UINT32_MAX
+  * @retval pulses
+  */
+uint32_t lmt_temperature_to_pulses(float temp);
+
 #ifdef __cplusplus
 }
 #endif /* End of CPP guard */
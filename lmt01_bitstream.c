@@ -0,0 +1,844 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        lmt01_bitstream.c
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file lmt01_bitstream.c
+ * @brief Counter-less LMT01 backend over packed GPIO sample buffers.
+ */
+#include "lmt01_bitstream.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/*!
+ * @brief This internal API counts the set bits of a word.
+ */
+static inline uint32_t popcount32(uint32_t x);
+
+/*!
+ * @brief This internal API returns the rising edges of word w, given the
+ * last sample of the previous word in carry.
+ */
+static inline uint32_t rising(uint32_t w, uint32_t carry);
+
+/*!
+ * @brief This internal API erodes word w by k samples: a sample stays set
+ * only if it and the k - 1 samples before it (reaching into prev) are set.
+ */
+static inline uint32_t erode(uint32_t w, uint32_t prev, uint32_t k);
+
+/*!
+ * @brief This internal API returns the last sample of prev eroded by k,
+ * which only depends on prev itself for k <= 32.
+ */
+static inline uint32_t erode_carry(uint32_t prev, uint32_t k);
+
+/*!
+ * @brief This internal API clamps a minimum width to 1..32 samples.
+ */
+static inline uint32_t clamp_width(uint32_t k);
+
+#if defined(__SSE2__)
+/*!
+ * @brief This internal API sums the set bits of a vector into two 64-bit
+ * lanes.
+ */
+static inline __m128i popcount_sse2(__m128i x);
+#endif
+
+/*!
+ * @brief This internal API reports the burst in progress, if any.
+ */
+static void end_burst(lmt_bitstream_t *bs);
+
+/*!
+ * @brief This internal API feeds one word (scalar path).
+ */
+static void feed_word(lmt_bitstream_t *bs, uint32_t w);
+
+/*!
+ * @brief This internal API feeds one block of LMT_BITSTREAM_BLOCK_WORDS
+ * words. Only valid when gap_words >= LMT_BITSTREAM_BLOCK_WORDS, so that a
+ * burst can only end at the start of the block or within its trailing
+ * zero words.
+ */
+static void feed_block(lmt_bitstream_t *bs, const uint32_t *buf);
+
+/*!
+ * @brief This internal API adds a word of 1-bit increments into a set of
+ * bit-sliced counters (plane k holds bit k of each lane's count).
+ */
+static inline void slice_add(uint32_t *planes, size_t depth, uint32_t inc);
+
+/*!
+ * @brief This internal API adds bit-sliced counters into per-lane counts.
+ */
+static void slice_transpose(const uint32_t *planes, size_t depth, uint32_t counts[LMT_BITSTREAM_LANES]);
+
+/*!
+ * @brief This internal API adds the rising edges on every lane of up to
+ * LMT_BITSTREAM_LANE_BLOCK port samples into counts. Longer blocks would
+ * overflow the bit-sliced counters.
+ */
+static uint32_t lanes_count_block(const uint32_t *samples, size_t n, uint32_t prev,
+                                  uint32_t counts[LMT_BITSTREAM_LANES]);
+
+/*!
+ * @brief This internal API applies the min_width filter to up to
+ * LMT_BITSTREAM_LANE_BLOCK port samples: a lane stays high only if it and
+ * the min_width - 1 samples before it (reaching into ml->hist) are high.
+ */
+static void lanes_erode(lmt_bitstream_lanes_t *ml, const uint32_t *samples, size_t n, uint32_t *out);
+
+/*
+ * @brief Bit-sliced counter depth. A lane can rise at most every other
+ * sample, so LMT_BITSTREAM_LANE_BLOCK / 2 per block.
+ */
+#define SLICE_DEPTH         8
+#define SLICE_DEPTH_VEC     6   /* Per vector element: a quarter of the samples */
+
+
+/**
+  * @brief  Count rising edges in a packed sample buffer, using the widest
+  *         kernel the target supports.
+  */
+uint32_t lmt_bitstream_count_edges(const uint32_t *buf, size_t words, uint32_t *carry)
+{
+#if defined(__AVX2__)
+    return lmt_bitstream_count_edges_avx2(buf, words, carry);
+#elif defined(__SSE2__)
+    return lmt_bitstream_count_edges_sse2(buf, words, carry);
+#elif defined(__ARM_NEON)
+    return lmt_bitstream_count_edges_neon(buf, words, carry);
+#else
+    return lmt_bitstream_count_edges_scalar(buf, words, carry);
+#endif
+}
+
+/**
+  * @brief  Scalar edge counting kernel.
+  */
+uint32_t lmt_bitstream_count_edges_scalar(const uint32_t *buf, size_t words, uint32_t *carry)
+{
+    uint32_t edges = 0;
+    uint32_t c = *carry;
+    size_t i;
+
+    for (i = 0; i < words; i++)
+    {
+        edges += popcount32(rising(buf[i], c));
+        c = buf[i] >> 31;
+    }
+
+    *carry = c;
+
+    return edges;
+}
+
+#if defined(__SSE2__)
+/**
+  * @brief  SSE2 edge counting kernel. Each vector is paired with an
+  *         unaligned load one word back, which supplies the carries.
+  */
+uint32_t lmt_bitstream_count_edges_sse2(const uint32_t *buf, size_t words, uint32_t *carry)
+{
+    if (words == 0)
+        return 0;
+
+    __m128i acc = _mm_setzero_si128();
+
+    uint32_t edges = popcount32(rising(buf[0], *carry));
+    size_t i = 1;
+
+    for (; i + 4 <= words; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(buf + i));
+        __m128i p = _mm_loadu_si128((const __m128i *)(buf + i - 1));
+        __m128i prev = _mm_or_si128(_mm_slli_epi32(v, 1), _mm_srli_epi32(p, 31));
+
+        acc = _mm_add_epi64(acc, popcount_sse2(_mm_andnot_si128(prev, v)));
+    }
+
+    edges += (uint32_t)_mm_cvtsi128_si32(acc) + (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+
+    uint32_t c = buf[i - 1] >> 31;
+    edges += lmt_bitstream_count_edges_scalar(buf + i, words - i, &c);
+    *carry = c;
+
+    return edges;
+}
+#endif
+
+#if defined(__AVX2__)
+/**
+  * @brief  AVX2 edge counting kernel, nibble lookup popcount.
+  */
+uint32_t lmt_bitstream_count_edges_avx2(const uint32_t *buf, size_t words, uint32_t *carry)
+{
+    if (words == 0)
+        return 0;
+
+    const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                         0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i m4 = _mm256_set1_epi8(0x0f);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc = _mm256_setzero_si256();
+
+    uint32_t edges = popcount32(rising(buf[0], *carry));
+    size_t i = 1;
+
+    for (; i + 8 <= words; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(buf + i));
+        __m256i p = _mm256_loadu_si256((const __m256i *)(buf + i - 1));
+        __m256i prev = _mm256_or_si256(_mm256_slli_epi32(v, 1), _mm256_srli_epi32(p, 31));
+        __m256i x = _mm256_andnot_si256(prev, v);
+
+        __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(x, m4));
+        __m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(x, 4), m4));
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_add_epi8(lo, hi), zero));
+    }
+
+    __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    edges += (uint32_t)_mm_cvtsi128_si32(sum) + (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+
+    uint32_t c = buf[i - 1] >> 31;
+    edges += lmt_bitstream_count_edges_scalar(buf + i, words - i, &c);
+    *carry = c;
+
+    return edges;
+}
+#endif
+
+#if defined(__ARM_NEON)
+/**
+  * @brief  NEON edge counting kernel.
+  */
+uint32_t lmt_bitstream_count_edges_neon(const uint32_t *buf, size_t words, uint32_t *carry)
+{
+    if (words == 0)
+        return 0;
+
+    uint64x2_t acc = vdupq_n_u64(0);
+
+    uint32_t edges = popcount32(rising(buf[0], *carry));
+    size_t i = 1;
+
+    for (; i + 4 <= words; i += 4)
+    {
+        uint32x4_t v = vld1q_u32(buf + i);
+        uint32x4_t p = vld1q_u32(buf + i - 1);
+        uint32x4_t prev = vorrq_u32(vshlq_n_u32(v, 1), vshrq_n_u32(p, 31));
+        uint8x16_t x = vreinterpretq_u8_u32(vbicq_u32(v, prev));
+
+        acc = vpadalq_u32(acc, vpaddlq_u16(vpaddlq_u8(vcntq_u8(x))));
+    }
+
+    edges += (uint32_t)(vgetq_lane_u64(acc, 0) + vgetq_lane_u64(acc, 1));
+
+    uint32_t c = buf[i - 1] >> 31;
+    edges += lmt_bitstream_count_edges_scalar(buf + i, words - i, &c);
+    *carry = c;
+
+    return edges;
+}
+#endif
+
+/**
+  * @brief  Count pulses at least min_width samples wide, using the widest
+  *         kernel the target supports.
+  */
+uint32_t lmt_bitstream_count_edges_filtered(const uint32_t *buf, size_t words,
+                                            uint32_t min_width, uint32_t *prev)
+{
+#if defined(__SSE2__)
+    return lmt_bitstream_count_edges_filtered_sse2(buf, words, min_width, prev);
+#else
+    return lmt_bitstream_count_edges_filtered_scalar(buf, words, min_width, prev);
+#endif
+}
+
+/**
+  * @brief  Scalar filtered counting kernel. Branch-free for a given width.
+  */
+uint32_t lmt_bitstream_count_edges_filtered_scalar(const uint32_t *buf, size_t words,
+                                                   uint32_t min_width, uint32_t *prev)
+{
+    uint32_t k = clamp_width(min_width);
+    uint32_t p = *prev;
+    uint32_t pulses = 0;
+    size_t i;
+
+    for (i = 0; i < words; i++)
+    {
+        pulses += popcount32(rising(erode(buf[i], p, k), erode_carry(p, k)));
+        p = buf[i];
+    }
+
+    *prev = p;
+
+    return pulses;
+}
+
+#if defined(__SSE2__)
+/**
+  * @brief  SSE2 filtered counting kernel. Each word is paired with the one
+  *         before it in a 64-bit lane, so erosion is a run of 64-bit shifts.
+  */
+uint32_t lmt_bitstream_count_edges_filtered_sse2(const uint32_t *buf, size_t words,
+                                                 uint32_t min_width, uint32_t *prev)
+{
+    if (words == 0)
+        return 0;
+
+    uint32_t k = clamp_width(min_width);
+    const __m128i ones = _mm_set1_epi32(-1);
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i csh = _mm_cvtsi32_si128((int)(32 - k));
+    __m128i acc = _mm_setzero_si128();
+
+    uint32_t pulses = popcount32(rising(erode(buf[0], *prev, k), erode_carry(*prev, k)));
+    size_t i = 1;
+    uint32_t j;
+
+    for (; i + 4 <= words; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(buf + i));
+        __m128i p = _mm_loadu_si128((const __m128i *)(buf + i - 1));
+        __m128i lo = _mm_unpacklo_epi32(p, v);
+        __m128i hi = _mm_unpackhi_epi32(p, v);
+        __m128i elo = ones;
+        __m128i ehi = ones;
+
+        for (j = 0; j < k; j++)
+        {
+            __m128i sh = _mm_cvtsi32_si128((int)(32 - j));
+            elo = _mm_and_si128(elo, _mm_srl_epi64(lo, sh));
+            ehi = _mm_and_si128(ehi, _mm_srl_epi64(hi, sh));
+        }
+
+        /* Low half of each 64-bit lane is the eroded word */
+        __m128i e = _mm_unpacklo_epi64(_mm_shuffle_epi32(elo, _MM_SHUFFLE(3, 1, 2, 0)),
+                                       _mm_shuffle_epi32(ehi, _MM_SHUFFLE(3, 1, 2, 0)));
+
+        /* Eroded last sample of each previous word */
+        __m128i ec = _mm_and_si128(_mm_cmpeq_epi32(_mm_srl_epi32(_mm_xor_si128(p, ones), csh), zero), one);
+
+        acc = _mm_add_epi64(acc, popcount_sse2(_mm_andnot_si128(_mm_or_si128(_mm_slli_epi32(e, 1), ec), e)));
+    }
+
+    pulses += (uint32_t)_mm_cvtsi128_si32(acc) + (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+
+    uint32_t pw = buf[i - 1];
+    pulses += lmt_bitstream_count_edges_filtered_scalar(buf + i, words - i, k, &pw);
+    *prev = pw;
+
+    return pulses;
+}
+#endif
+
+/**
+  * @brief  Reset decoder state, keeping the options.
+  */
+void lmt_bitstream_reset(lmt_bitstream_t *bs)
+{
+    bs->prev = 0;
+    bs->pulses = 0;
+    bs->raw = 0;
+    bs->glitches = 0;
+    bs->zero_run = 0;
+}
+
+/**
+  * @brief  Feed the next buffer of samples.
+  */
+void lmt_bitstream_feed(lmt_bitstream_t *bs, const uint32_t *buf, size_t words)
+{
+    size_t i = 0;
+
+    /* Whole blocks go through the vectorised kernel when gaps are long
+       enough that a block cannot hide a burst boundary. */
+    if (bs->gap_words >= LMT_BITSTREAM_BLOCK_WORDS)
+    {
+        for (; i + LMT_BITSTREAM_BLOCK_WORDS <= words; i += LMT_BITSTREAM_BLOCK_WORDS)
+            feed_block(bs, buf + i);
+    }
+
+    for (; i < words; i++)
+        feed_word(bs, buf[i]);
+}
+
+/**
+  * @brief  Count rising edges on every lane of a buffer of port samples,
+  *         a block of LMT_BITSTREAM_LANE_BLOCK at a time.
+  */
+uint32_t lmt_bitstream_lanes_count(const uint32_t *samples, size_t n, uint32_t prev,
+                                   uint32_t counts[LMT_BITSTREAM_LANES])
+{
+    uint32_t active = 0;
+    size_t i;
+
+    for (i = 0; i < LMT_BITSTREAM_LANES; i++)
+        counts[i] = 0;
+
+    for (i = 0; i < n; i += LMT_BITSTREAM_LANE_BLOCK)
+    {
+        size_t blk = (n - i < LMT_BITSTREAM_LANE_BLOCK) ? n - i : LMT_BITSTREAM_LANE_BLOCK;
+
+        active |= lanes_count_block(samples + i, blk, (i == 0) ? prev : samples[i - 1], counts);
+    }
+
+    return active;
+}
+
+/*!
+ * @brief This internal API counts rising edges on every lane of a block of
+ * port samples. Edges are accumulated in bit-sliced counters, so the cost
+ * per sample does not depend on the number of lanes.
+ */
+static uint32_t lanes_count_block(const uint32_t *samples, size_t n, uint32_t prev,
+                                  uint32_t counts[LMT_BITSTREAM_LANES])
+{
+    uint32_t planes[SLICE_DEPTH] = {0};
+    uint32_t active = 0;
+    size_t i = 0;
+
+    if (n == 0)
+        return 0;
+
+    /* First sample pairs with the caller's previous sample */
+    slice_add(planes, SLICE_DEPTH, samples[0] & ~prev);
+    active |= samples[0];
+    i = 1;
+
+#if defined(__SSE2__) || defined(__ARM_NEON)
+    /* Four independent counter sets, one per vector element, each paired
+       with an unaligned load one sample back. */
+    {
+#if defined(__SSE2__)
+        __m128i vp[SLICE_DEPTH_VEC];
+        __m128i vact = _mm_setzero_si128();
+        size_t k;
+
+        for (k = 0; k < SLICE_DEPTH_VEC; k++)
+            vp[k] = _mm_setzero_si128();
+
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128i v = _mm_loadu_si128((const __m128i *)(samples + i));
+            __m128i c = _mm_andnot_si128(_mm_loadu_si128((const __m128i *)(samples + i - 1)), v);
+
+            vact = _mm_or_si128(vact, v);
+
+            for (k = 0; k < SLICE_DEPTH_VEC; k++)
+            {
+                __m128i t = _mm_and_si128(vp[k], c);
+                vp[k] = _mm_xor_si128(vp[k], c);
+                c = t;
+            }
+        }
+
+        /* Split into one plane set per element and fold into counts */
+        uint32_t elem[4][SLICE_DEPTH_VEC];
+        uint32_t lanes[4];
+        size_t e;
+
+        for (k = 0; k < SLICE_DEPTH_VEC; k++)
+        {
+            _mm_storeu_si128((__m128i *)lanes, vp[k]);
+
+            for (e = 0; e < 4; e++)
+                elem[e][k] = lanes[e];
+        }
+
+        for (e = 0; e < 4; e++)
+            slice_transpose(elem[e], SLICE_DEPTH_VEC, counts);
+
+        _mm_storeu_si128((__m128i *)lanes, vact);
+        active |= lanes[0] | lanes[1] | lanes[2] | lanes[3];
+#else
+        uint32x4_t vp[SLICE_DEPTH_VEC];
+        uint32x4_t vact = vdupq_n_u32(0);
+        size_t k;
+
+        for (k = 0; k < SLICE_DEPTH_VEC; k++)
+            vp[k] = vdupq_n_u32(0);
+
+        for (; i + 4 <= n; i += 4)
+        {
+            uint32x4_t v = vld1q_u32(samples + i);
+            uint32x4_t c = vbicq_u32(v, vld1q_u32(samples + i - 1));
+
+            vact = vorrq_u32(vact, v);
+
+            for (k = 0; k < SLICE_DEPTH_VEC; k++)
+            {
+                uint32x4_t t = vandq_u32(vp[k], c);
+                vp[k] = veorq_u32(vp[k], c);
+                c = t;
+            }
+        }
+
+        uint32_t elem[4][SLICE_DEPTH_VEC];
+        uint32_t lanes[4];
+        size_t e;
+
+        for (k = 0; k < SLICE_DEPTH_VEC; k++)
+        {
+            vst1q_u32(lanes, vp[k]);
+
+            for (e = 0; e < 4; e++)
+                elem[e][k] = lanes[e];
+        }
+
+        for (e = 0; e < 4; e++)
+            slice_transpose(elem[e], SLICE_DEPTH_VEC, counts);
+
+        vst1q_u32(lanes, vact);
+        active |= lanes[0] | lanes[1] | lanes[2] | lanes[3];
+#endif
+    }
+#endif
+
+    for (; i < n; i++)
+    {
+        slice_add(planes, SLICE_DEPTH, samples[i] & ~samples[i - 1]);
+        active |= samples[i];
+    }
+
+    slice_transpose(planes, SLICE_DEPTH, counts);
+
+    return active;
+}
+
+/**
+  * @brief  Reset multi-lane decoder state, keeping the options.
+  */
+void lmt_bitstream_lanes_reset(lmt_bitstream_lanes_t *ml)
+{
+    size_t i;
+
+    ml->prev = 0;
+
+    for (i = 0; i < LMT_BITSTREAM_LANES; i++)
+    {
+        ml->pulses[i] = 0;
+        ml->quiet[i] = 0;
+    }
+
+    for (i = 0; i < sizeof(ml->hist) / sizeof(ml->hist[0]); i++)
+        ml->hist[i] = 0;
+}
+
+/**
+  * @brief  Feed the next buffer of port samples.
+  */
+void lmt_bitstream_lanes_feed(lmt_bitstream_lanes_t *ml, const uint32_t *samples, size_t n)
+{
+    uint32_t counts[LMT_BITSTREAM_LANES];
+    uint32_t eroded[LMT_BITSTREAM_LANE_BLOCK];
+
+    while (n > 0)
+    {
+        size_t blk = (n < LMT_BITSTREAM_LANE_BLOCK) ? n : LMT_BITSTREAM_LANE_BLOCK;
+        const uint32_t *in = samples;
+        uint32_t active;
+        uint8_t lane;
+
+        /* Glitches never reach the counters, nor keep a lane active */
+        if (ml->min_width > 1)
+        {
+            lanes_erode(ml, samples, blk, eroded);
+            in = eroded;
+        }
+
+        active = lmt_bitstream_lanes_count(in, blk, ml->prev, counts);
+
+        for (lane = 0; lane < LMT_BITSTREAM_LANES; lane++)
+        {
+            if (!(ml->lane_mask & (1u << lane)))
+                continue;
+
+            ml->pulses[lane] += counts[lane];
+
+            if (active & (1u << lane))
+            {
+                ml->quiet[lane] = 0;
+                continue;
+            }
+
+            ml->quiet[lane] += (uint32_t)blk;
+
+            /* Lane quiet long enough: its burst is over */
+            if (ml->gap_samples != 0 && ml->quiet[lane] >= ml->gap_samples && ml->pulses[lane] != 0)
+            {
+                if (ml->burst_cb != NULL)
+                    ml->burst_cb(ml->burst_ctx, lane, ml->pulses[lane]);
+
+                ml->pulses[lane] = 0;
+            }
+        }
+
+        ml->prev = in[blk - 1];
+        samples += blk;
+        n -= blk;
+    }
+}
+
+/*!
+ * @brief This internal API applies the min_width filter to port samples.
+ */
+static void lanes_erode(lmt_bitstream_lanes_t *ml, const uint32_t *samples, size_t n, uint32_t *out)
+{
+    uint32_t k = clamp_width(ml->min_width);
+    size_t i, j;
+
+    for (i = 0; i < n; i++)
+    {
+        uint32_t e = samples[i];
+
+        for (j = 1; j < k; j++)
+            e &= (i >= j) ? samples[i - j] : ml->hist[j - i - 1];
+
+        out[i] = e;
+    }
+
+    /* Keep the last k - 1 raw samples; top down, so hist[j - n] is
+       still the old value when it is moved */
+    for (j = k - 1; j-- > 0;)
+        ml->hist[j] = (j < n) ? samples[n - 1 - j] : ml->hist[j - n];
+}
+
+/*!
+ * @brief This internal API counts the set bits of a word.
+ */
+static inline uint32_t popcount32(uint32_t x)
+{
+#if defined(__GNUC__)
+    return (uint32_t)__builtin_popcount(x);
+#else
+    x = x - ((x >> 1) & 0x55555555u);
+    x = (x & 0x33333333u) + ((x >> 2) & 0x33333333u);
+    x = (x + (x >> 4)) & 0x0f0f0f0fu;
+    return (x * 0x01010101u) >> 24;
+#endif
+}
+
+/*!
+ * @brief This internal API adds 1-bit increments into bit-sliced counters.
+ */
+static inline void slice_add(uint32_t *planes, size_t depth, uint32_t inc)
+{
+    size_t k;
+
+    /* Ripple carry; usually stops after a plane or two */
+    for (k = 0; k < depth && inc != 0; k++)
+    {
+        uint32_t carry = planes[k] & inc;
+        planes[k] ^= inc;
+        inc = carry;
+    }
+}
+
+/*!
+ * @brief This internal API adds bit-sliced counters into per-lane counts.
+ */
+static void slice_transpose(const uint32_t *planes, size_t depth, uint32_t counts[LMT_BITSTREAM_LANES])
+{
+    size_t k;
+
+    for (k = 0; k < depth; k++)
+    {
+        uint32_t bits = planes[k];
+
+        /* Visit set bits only */
+        while (bits != 0)
+        {
+            uint32_t lane = popcount32((bits & (0u - bits)) - 1);
+            counts[lane] += 1u << k;
+            bits &= bits - 1;
+        }
+    }
+}
+
+/*!
+ * @brief This internal API returns the rising edges of a word.
+ */
+static inline uint32_t rising(uint32_t w, uint32_t carry)
+{
+    return w & ~((w << 1) | carry);
+}
+
+/*!
+ * @brief This internal API erodes a word by k samples.
+ */
+static inline uint32_t erode(uint32_t w, uint32_t prev, uint32_t k)
+{
+    uint64_t x = ((uint64_t)w << 32) | prev;
+    uint32_t e = 0xffffffffu;
+    uint32_t i;
+
+    for (i = 0; i < k; i++)
+        e &= (uint32_t)(x >> (32 - i));
+
+    return e;
+}
+
+/*!
+ * @brief This internal API returns the eroded last sample of a word.
+ */
+static inline uint32_t erode_carry(uint32_t prev, uint32_t k)
+{
+    return (~prev >> (32 - k)) == 0;
+}
+
+/*!
+ * @brief This internal API clamps a minimum width.
+ */
+static inline uint32_t clamp_width(uint32_t k)
+{
+    if (k < 1)
+        return 1;
+
+    return (k > 32) ? 32 : k;
+}
+
+#if defined(__SSE2__)
+/*!
+ * @brief This internal API sums the set bits of a vector.
+ */
+static inline __m128i popcount_sse2(__m128i x)
+{
+    const __m128i m1 = _mm_set1_epi8(0x55);
+    const __m128i m2 = _mm_set1_epi8(0x33);
+    const __m128i m4 = _mm_set1_epi8(0x0f);
+
+    /* Per-byte popcount, then horizontal byte sum */
+    x = _mm_sub_epi8(x, _mm_and_si128(_mm_srli_epi16(x, 1), m1));
+    x = _mm_add_epi8(_mm_and_si128(x, m2), _mm_and_si128(_mm_srli_epi16(x, 2), m2));
+    x = _mm_and_si128(_mm_add_epi8(x, _mm_srli_epi16(x, 4)), m4);
+
+    return _mm_sad_epu8(x, _mm_setzero_si128());
+}
+#endif
+
+/*!
+ * @brief This internal API reports the burst in progress, if any, and
+ * tallies the edges the filter rejected within it.
+ */
+static void end_burst(lmt_bitstream_t *bs)
+{
+    if (bs->raw == 0)
+        return;
+
+    bs->glitches += bs->raw - bs->pulses;
+
+    if (bs->pulses != 0 && bs->burst_cb != NULL)
+        bs->burst_cb(bs->burst_ctx, bs->pulses);
+
+    bs->pulses = 0;
+    bs->raw = 0;
+}
+
+/*!
+ * @brief This internal API feeds one word.
+ */
+static void feed_word(lmt_bitstream_t *bs, uint32_t w)
+{
+    if (w == 0)
+    {
+        bs->prev = 0;
+        bs->zero_run++;
+
+        if (bs->gap_words != 0 && bs->zero_run >= bs->gap_words)
+            end_burst(bs);
+        return;
+    }
+
+    uint32_t edges = popcount32(rising(w, bs->prev >> 31));
+
+    bs->raw += edges;
+
+    if (bs->min_width > 1)
+        edges = popcount32(rising(erode(w, bs->prev, clamp_width(bs->min_width)),
+                                  erode_carry(bs->prev, clamp_width(bs->min_width))));
+
+    bs->pulses += edges;
+    bs->prev = w;
+    bs->zero_run = 0;
+}
+
+/*!
+ * @brief This internal API feeds one block of words.
+ */
+static void feed_block(lmt_bitstream_t *bs, const uint32_t *buf)
+{
+    size_t head = 0;
+    size_t tail = 0;
+
+    while (head < LMT_BITSTREAM_BLOCK_WORDS && buf[head] == 0)
+        head++;
+
+    /* Quiet block: only extends the gap */
+    if (head == LMT_BITSTREAM_BLOCK_WORDS)
+    {
+        bs->prev = 0;
+        bs->zero_run += LMT_BITSTREAM_BLOCK_WORDS;
+
+        if (bs->zero_run >= bs->gap_words)
+            end_burst(bs);
+        return;
+    }
+
+    /* Leading zeros may complete the gap after the previous burst */
+    if (bs->zero_run + head >= bs->gap_words)
+        end_burst(bs);
+
+    uint32_t carry = bs->prev >> 31;
+    uint32_t edges = lmt_bitstream_count_edges(buf, LMT_BITSTREAM_BLOCK_WORDS, &carry);
+
+    bs->raw += edges;
+
+    if (bs->min_width > 1)
+        edges = lmt_bitstream_count_edges_filtered(buf, LMT_BITSTREAM_BLOCK_WORDS, bs->min_width, &bs->prev);
+
+    bs->pulses += edges;
+    bs->prev = buf[LMT_BITSTREAM_BLOCK_WORDS - 1];
+
+    while (buf[LMT_BITSTREAM_BLOCK_WORDS - 1 - tail] == 0)
+        tail++;
+
+    bs->zero_run = (uint32_t)tail;
+}
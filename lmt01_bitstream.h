@@ -0,0 +1,263 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        lmt01_bitstream.h
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file lmt01_bitstream.h
+ * @brief Counter-less LMT01 backend: counts pulses in a buffer of GPIO
+ *        samples (e.g. filled by DMA from the input register at a fixed
+ *        rate) instead of with a hardware counter.
+ *
+ * Samples are packed one bit per sample, 32 to a word, earliest sample in
+ * bit 0.
+ */
+
+#ifndef _LMT01_BITSTREAM_H_
+#define _LMT01_BITSTREAM_H_
+
+/*! CPP guard */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*!
+ * @brief Words handled per block by lmt_bitstream_feed(). Gaps of at least
+ *        this many words take the vectorised path.
+ */
+#define LMT_BITSTREAM_BLOCK_WORDS   64
+
+/*!
+ * @brief Port samples handled per block by lmt_bitstream_lanes_feed().
+ *        Burst ends are detected to this resolution.
+ */
+#define LMT_BITSTREAM_LANE_BLOCK    256
+
+/*!
+ * @brief Maximum number of lanes (bits of a port sample)
+ */
+#define LMT_BITSTREAM_LANES         32
+
+/*!
+ * @brief Type definitions
+ */
+typedef void (*lmt_burst_fptr_t)(void *ctx, uint32_t pulses);
+typedef void (*lmt_lane_burst_fptr_t)(void *ctx, uint8_t lane, uint32_t pulses);
+
+/*!
+ * @brief  Bitstream decoder state
+ */
+typedef struct
+{
+    /* Option: number of all-zero words that marks the end of a burst.
+       Must cover more than the longest low time within a burst. */
+    uint32_t gap_words;
+
+    /* Option: called with the pulse count of each completed burst */
+    lmt_burst_fptr_t burst_cb;
+
+    /* Option: context passed to burst_cb */
+    void *burst_ctx;
+
+    /* Option: minimum pulse width (samples, at most 32). Shorter high
+       runs are rejected as glitches. 0 or 1 disables the filter. Only
+       highs are filtered: a low dropout inside a pulse still splits it
+       in two, so the line must not ring low. */
+    uint32_t min_width;
+
+    /* Previous word */
+    uint32_t prev;
+
+    /* Pulses counted in the burst in progress */
+    uint32_t pulses;
+
+    /* Unfiltered rising edges in the burst in progress */
+    uint32_t raw;
+
+    /* Total edges rejected by the min_width filter */
+    uint32_t glitches;
+
+    /* All-zero words seen since the last pulse */
+    uint32_t zero_run;
+
+} lmt_bitstream_t;
+
+/*!
+ * @brief  Multi-lane decoder state. Each sample is one read of a GPIO port
+ *         and each bit (lane) carries a different sensor.
+ */
+typedef struct
+{
+    /* Option: mask of lanes with a sensor attached */
+    uint32_t lane_mask;
+
+    /* Option: quiet samples on a lane that end its burst. Should exceed
+       LMT_BITSTREAM_LANE_BLOCK by a good margin. */
+    uint32_t gap_samples;
+
+    /* Option: called with the pulse count of each completed burst */
+    lmt_lane_burst_fptr_t burst_cb;
+
+    /* Option: context passed to burst_cb */
+    void *burst_ctx;
+
+    /* Option: minimum pulse width (samples, at most 32) on every lane.
+       Shorter high runs are rejected as glitches. 0 or 1 disables the
+       filter. Costs min_width - 1 ANDs per sample. As for one lane,
+       only highs are filtered, not low dropouts inside a pulse. */
+    uint32_t min_width;
+
+    /* Previous port sample, filtered if min_width is set */
+    uint32_t prev;
+
+    /* Last raw port samples, latest first, for the min_width filter */
+    uint32_t hist[31];
+
+    /* Pulses counted in the burst in progress, per lane */
+    uint32_t pulses[LMT_BITSTREAM_LANES];
+
+    /* Samples since the lane was last high, per lane */
+    uint32_t quiet[LMT_BITSTREAM_LANES];
+
+} lmt_bitstream_lanes_t;
+
+/**
+  * @brief  Count rising edges on every lane of a buffer of port samples,
+  *         split into blocks of LMT_BITSTREAM_LANE_BLOCK. Unfiltered:
+  *         every edge counts, see min_width in lmt_bitstream_lanes_t for
+  *         glitch rejection.
+  * 
+  * @param[in] samples : Port samples.
+  * @param[in] n : Number of samples.
+  * @param[in] prev : Port sample before samples[0].
+  * @param[out] counts : Rising edges per lane.
+  * 
+  * @return OR of all samples (lanes that were high at some point)
+  * @retval active
+  */
+uint32_t lmt_bitstream_lanes_count(const uint32_t *samples, size_t n, uint32_t prev,
+                                   uint32_t counts[LMT_BITSTREAM_LANES]);
+
+/**
+  * @brief  Reset multi-lane decoder state, keeping the options.
+  * 
+  * @param[in,out] ml : Multi-lane decoder.
+  */
+void lmt_bitstream_lanes_reset(lmt_bitstream_lanes_t *ml);
+
+/**
+  * @brief  Feed the next buffer of port samples. burst_cb is called for
+  *         every lane whose burst ends within it. With min_width set, a
+  *         pulse counts once it has been high for min_width samples, as
+  *         lmt_bitstream_count_edges_filtered() does for one lane.
+  * 
+  * @param[in,out] ml : Multi-lane decoder.
+  * @param[in] samples : Port samples.
+  * @param[in] n : Number of samples.
+  */
+void lmt_bitstream_lanes_feed(lmt_bitstream_lanes_t *ml, const uint32_t *samples, size_t n);
+
+/**
+  * @brief  Count rising edges in a packed sample buffer.
+  * 
+  * @param[in] buf : Packed samples.
+  * @param[in] words : Number of words in buf.
+  * @param[in,out] carry : Last sample before buf on entry (0 or 1),
+  *                        last sample of buf on exit.
+  * 
+  * @return Number of rising edges
+  * @retval edges
+  */
+uint32_t lmt_bitstream_count_edges(const uint32_t *buf, size_t words, uint32_t *carry);
+
+/**
+  * @brief  Kernels behind lmt_bitstream_count_edges(), each only present
+  *         when the target supports it. Same contract as above.
+  */
+uint32_t lmt_bitstream_count_edges_scalar(const uint32_t *buf, size_t words, uint32_t *carry);
+#if defined(__SSE2__)
+uint32_t lmt_bitstream_count_edges_sse2(const uint32_t *buf, size_t words, uint32_t *carry);
+#endif
+#if defined(__AVX2__)
+uint32_t lmt_bitstream_count_edges_avx2(const uint32_t *buf, size_t words, uint32_t *carry);
+#endif
+#if defined(__ARM_NEON)
+uint32_t lmt_bitstream_count_edges_neon(const uint32_t *buf, size_t words, uint32_t *carry);
+#endif
+
+/**
+  * @brief  Count pulses at least min_width samples wide in a packed
+  *         sample buffer of one lane. Each word is eroded by min_width:
+  *         a sample survives only if it and the min_width - 1 before it
+  *         are high. A run then yields one edge if it is wide enough and
+  *         none otherwise.
+  * 
+  * @param[in] buf : Packed samples.
+  * @param[in] words : Number of words in buf.
+  * @param[in] min_width : Minimum pulse width (samples, 1 to 32).
+  * @param[in,out] prev : Word before buf on entry, last word of buf on exit.
+  * 
+  * @return Number of pulses
+  * @retval pulses
+  */
+uint32_t lmt_bitstream_count_edges_filtered(const uint32_t *buf, size_t words,
+                                            uint32_t min_width, uint32_t *prev);
+
+/**
+  * @brief  Kernels behind lmt_bitstream_count_edges_filtered(), each only
+  *         present when the target supports it. Same contract as above.
+  */
+uint32_t lmt_bitstream_count_edges_filtered_scalar(const uint32_t *buf, size_t words,
+                                                   uint32_t min_width, uint32_t *prev);
+#if defined(__SSE2__)
+uint32_t lmt_bitstream_count_edges_filtered_sse2(const uint32_t *buf, size_t words,
+                                                 uint32_t min_width, uint32_t *prev);
+#endif
+
+/**
+  * @brief  Reset decoder state, keeping the options.
+  * 
+  * @param[in,out] bs : Bitstream decoder.
+  */
+void lmt_bitstream_reset(lmt_bitstream_t *bs);
+
+/**
+  * @brief  Feed the next buffer of samples. burst_cb is called for every
+  *         burst that ends within it; a burst may span any number of calls.
+  * 
+  * @param[in,out] bs : Bitstream decoder.
+  * @param[in] buf : Packed samples.
+  * @param[in] words : Number of words in buf.
+  */
+void lmt_bitstream_feed(lmt_bitstream_t *bs, const uint32_t *buf, size_t words);
+
+#ifdef __cplusplus
+}
+#endif /* End of CPP guard */
+#endif /* _LMT01_BITSTREAM_H_ */
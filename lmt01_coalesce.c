@@ -0,0 +1,168 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        lmt01_coalesce.c
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file lmt01_coalesce.c
+ * @brief Wakeup coalescing planner.
+ *
+ * Greedy: devices are taken shortest period first. Each one joins the
+ * group with the longest tick that has a multiple within the slack of its
+ * period, or starts a group ticking at its own period. Longer ticks
+ * leave fewer wakeups for the devices that follow.
+ */
+#include "lmt01_coalesce.h"
+#include <stddef.h>
+
+#define MS_PER_HOUR     3600000ul
+
+/*!
+ * @brief This internal API returns |a - b|.
+ */
+static uint32_t abs_diff(uint32_t a, uint32_t b);
+
+
+/**
+  * @brief  Group devices onto shared ticks.
+  */
+lmt_status_t lmt_coalesce_plan(lmt_coalesce_t *plan, uint32_t n, uint32_t slack_ms, uint32_t *n_groups)
+{
+    uint32_t groups = 0;
+    uint32_t i, j, k, best, next;
+
+    if (plan == NULL)
+        return LMT_E_NULL_PTR;
+
+    for (i = 0; i < n; i++)
+    {
+        if (plan[i].period_ms == 0)
+            return LMT_E_INVALID;
+
+        plan[i].tick_ms = 0;
+    }
+
+    /* tick_ms is 0 until a device is placed */
+    for (i = 0; i < n; i++)
+    {
+        next = n;
+
+        for (j = 0; j < n; j++)
+        {
+            if (plan[j].tick_ms == 0 && (next == n || plan[j].period_ms < plan[next].period_ms))
+                next = j;
+        }
+
+        /* Best group so far, by any device already placed in it */
+        best = n;
+
+        for (j = 0; j < n; j++)
+        {
+            if (plan[j].tick_ms == 0)
+                continue;
+
+            k = (plan[next].period_ms + plan[j].tick_ms / 2) / plan[j].tick_ms;
+
+            if (k == 0 || abs_diff(k * plan[j].tick_ms, plan[next].period_ms) > slack_ms)
+                continue;
+
+            if (best == n || plan[j].tick_ms > plan[best].tick_ms)
+                best = j;
+        }
+
+        if (best == n)
+        {
+            plan[next].group = groups++;
+            plan[next].tick_ms = plan[next].period_ms;
+            plan[next].divisor = 1;
+        }
+        else
+        {
+            plan[next].group = plan[best].group;
+            plan[next].tick_ms = plan[best].tick_ms;
+            plan[next].divisor = (plan[next].period_ms + plan[best].tick_ms / 2) / plan[best].tick_ms;
+        }
+    }
+
+    if (n_groups != NULL)
+        *n_groups = groups;
+
+    return LMT_OK;
+}
+
+/**
+  * @brief  Whether a device is due on a tick of its group.
+  */
+uint8_t lmt_coalesce_due(const lmt_coalesce_t *plan, uint32_t tick)
+{
+    return (tick % plan->divisor) == 0;
+}
+
+/**
+  * @brief  Sampling wakeups per hour.
+  */
+uint32_t lmt_coalesce_wakeups_per_hour(const lmt_coalesce_t *plan, uint32_t n, uint8_t coalesced)
+{
+    uint32_t wakeups = 0;
+    uint32_t i, j, tick;
+
+    for (i = 0; i < n; i++)
+    {
+        if (!coalesced)
+        {
+            wakeups += MS_PER_HOUR / plan[i].period_ms;
+            continue;
+        }
+
+        /* Count each group once, from its first device */
+        for (j = 0; j < i && plan[j].group != plan[i].group; j++);
+
+        if (j != i)
+            continue;
+
+        for (tick = 0; tick < MS_PER_HOUR / plan[i].tick_ms; tick++)
+        {
+            for (j = i; j < n; j++)
+            {
+                if (plan[j].group == plan[i].group && lmt_coalesce_due(&plan[j], tick))
+                {
+                    wakeups++;
+                    break;
+                }
+            }
+        }
+    }
+
+    return wakeups;
+}
+
+/*!
+ * @brief This internal API returns |a - b|.
+ */
+static uint32_t abs_diff(uint32_t a, uint32_t b)
+{
+    return (a > b) ? a - b : b - a;
+}
@@ -0,0 +1,111 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        lmt01_coalesce.h
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file lmt01_coalesce.h
+ * @brief Wakeup coalescing for devices sampled at different periods.
+ *        Periods that are within a slack of a multiple of a shared tick
+ *        are grouped onto that tick. All devices due on a tick are then
+ *        read together (lmt_get_pulse_count_multi, or wheel readers
+ *        started on the same tick), so they share their wakeups.
+ */
+
+#ifndef _LMT01_COALESCE_H_
+#define _LMT01_COALESCE_H_
+
+/*! CPP guard */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "lmt01.h"
+
+/*!
+ * @brief  Sampling plan of one device
+ */
+typedef struct
+{
+    /* Option: requested sampling period (ms) */
+    uint32_t period_ms;
+
+    /* Group the device was put in */
+    uint32_t group;
+
+    /* Tick of the group (ms) */
+    uint32_t tick_ms;
+
+    /* Sampled every divisor ticks, i.e. every divisor * tick_ms */
+    uint32_t divisor;
+
+} lmt_coalesce_t;
+
+/**
+  * @brief  Group devices onto shared ticks. Every device ends up sampled
+  *         every divisor * tick_ms, within slack_ms of its requested
+  *         period. Groups are started from the same tick.
+  * 
+  * @param[in,out] plan : Per-device plan, period_ms filled in.
+  * @param[in] n : Number of devices.
+  * @param[in] slack_ms : Largest allowed change of a period (ms).
+  * @param[out] n_groups : Number of groups (may be NULL).
+  * 
+  * @return result of API execution status
+  * @retval LMT_E_INVALID if a period is 0
+  */
+lmt_status_t lmt_coalesce_plan(lmt_coalesce_t *plan, uint32_t n, uint32_t slack_ms, uint32_t *n_groups);
+
+/**
+  * @brief  Whether a device is due on a tick of its group.
+  * 
+  * @param[in] plan : Plan of the device.
+  * @param[in] tick : Tick count of the group since it was started.
+  * 
+  * @return Non-zero if due
+  */
+uint8_t lmt_coalesce_due(const lmt_coalesce_t *plan, uint32_t tick);
+
+/**
+  * @brief  Sampling wakeups per hour. Coalesced, a wakeup is a tick on
+  *         which any device of a group is due. Uncoalesced, every
+  *         device wakes on its own at its requested period. Each wakeup
+  *         is one acquisition, which takes the same handful of timer
+  *         wakeups either way. Costs one step per group tick in an hour.
+  * 
+  * @param[in] plan : Per-device plan.
+  * @param[in] n : Number of devices.
+  * @param[in] coalesced : Count for the plan (1) or without it (0).
+  * 
+  * @return Wakeups per hour
+  */
+uint32_t lmt_coalesce_wakeups_per_hour(const lmt_coalesce_t *plan, uint32_t n, uint8_t coalesced);
+
+#ifdef __cplusplus
+}
+#endif /* End of CPP guard */
+#endif /* _LMT01_COALESCE_H_ */
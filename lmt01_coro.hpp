@@ -0,0 +1,233 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Sean Farrelly
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        lmt01_coro.hpp
+ * Created by  Sean Farrelly
+ * Version     1.0
+ *
+ */
+
+/*! @file lmt01_coro.hpp
+ * @brief C++20 coroutine wrapper over the non-blocking LMT01 reading engine.
+ *
+ * `co_await lmt::read(&dev)` suspends the calling coroutine until the reading
+ * completes. Waits are queued on a single-threaded executor, so any number of
+ * readings can be in flight without a stack each.
+ */
+
+#ifndef _LMT01_CORO_HPP_
+#define _LMT01_CORO_HPP_
+
+#include "lmt01.h"
+
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace lmt {
+
+/*!
+ * @brief  Single-threaded timer executor. Runs each queued callback once its
+ *         deadline has passed, sleeping in between. Time comes from
+ *         steady_clock unless a clock is given, e.g. the simulator's
+ *         virtual clock.
+ */
+class executor
+{
+public:
+    /* Current time (us), and sleep until an absolute time (us) */
+    using now_fn = std::function<uint64_t()>;
+    using sleep_until_fn = std::function<void(uint64_t)>;
+
+    executor() : now_us_(steady_now_us), sleep_until_us_(steady_sleep_until_us) {}
+
+    executor(now_fn now_us, sleep_until_fn sleep_until_us)
+        : now_us_(std::move(now_us)), sleep_until_us_(std::move(sleep_until_us)) {}
+
+    /* Queue fn to run ms milliseconds from now */
+    void post_after(uint32_t ms, std::function<void()> fn)
+    {
+        queue_.push({now_us_() + (uint64_t)ms * 1000, seq_++, std::move(fn)});
+    }
+
+    /* Run until no callbacks remain */
+    void run()
+    {
+        while (!queue_.empty())
+        {
+            /* Move, not copy, the callback out. The keys are integers
+               and survive the move, so pop() still sees the heap order. */
+            entry e = std::move(const_cast<entry &>(queue_.top()));
+            queue_.pop();
+
+            if (e.deadline_us > now_us_())
+                sleep_until_us_(e.deadline_us);
+
+            e.fn();
+        }
+    }
+
+private:
+    struct entry
+    {
+        uint64_t deadline_us;
+        uint64_t seq;
+        std::function<void()> fn;
+
+        bool operator>(const entry &o) const
+        {
+            return deadline_us != o.deadline_us ? deadline_us > o.deadline_us : seq > o.seq;
+        }
+    };
+
+    static uint64_t steady_now_us()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static void steady_sleep_until_us(uint64_t t_us)
+    {
+        std::this_thread::sleep_until(std::chrono::steady_clock::time_point(
+            std::chrono::microseconds(t_us)));
+    }
+
+    now_fn now_us_;
+    sleep_until_fn sleep_until_us_;
+    std::priority_queue<entry, std::vector<entry>, std::greater<entry>> queue_;
+    uint64_t seq_ = 0;
+};
+
+/*!
+ * @brief  Per-thread executor used when none is given explicitly.
+ */
+inline executor &default_executor()
+{
+    static thread_local executor ex;
+    return ex;
+}
+
+/*!
+ * @brief  Result of an awaited reading.
+ */
+struct reading
+{
+    lmt_status_t rslt;
+    uint32_t pulses;
+};
+
+/*!
+ * @brief  Awaitable returned by lmt::read().
+ */
+class read_awaitable
+{
+public:
+    read_awaitable(executor &ex, const lmt01_dev_t *dev) : ex_(ex), dev_(dev) {}
+
+    /* Only the option fields of opts are used */
+    read_awaitable(executor &ex, const lmt01_dev_t *dev, const lmt_read_t &opts) : ex_(ex), dev_(dev)
+    {
+        rd_.poll_ms = opts.poll_ms;
+        rd_.alarm_pulses = opts.alarm_pulses;
+        rd_.alarm_cb = opts.alarm_cb;
+        rd_.alarm_ctx = opts.alarm_ctx;
+    }
+
+    bool await_ready()
+    {
+        rslt_ = lmt_read_start(dev_, &rd_);
+        return rslt_ != LMT_BUSY;
+    }
+
+    void await_suspend(std::coroutine_handle<> h)
+    {
+        handle_ = h;
+        schedule();
+    }
+
+    reading await_resume() const
+    {
+        return {rslt_, rslt_ == LMT_OK ? rd_.pulses : 0};
+    }
+
+private:
+    void schedule()
+    {
+        ex_.post_after(rd_.wait_ms, [this] {
+            rslt_ = lmt_read_step(&rd_);
+
+            if (rslt_ == LMT_BUSY)
+                schedule();
+            else
+                handle_.resume();
+        });
+    }
+
+    executor &ex_;
+    const lmt01_dev_t *dev_;
+    lmt_read_t rd_{};
+    lmt_status_t rslt_ = LMT_BUSY;
+    std::coroutine_handle<> handle_;
+};
+
+/*!
+ * @brief  Read one pulse count from dev without blocking the thread.
+ */
+inline read_awaitable read(const lmt01_dev_t *dev, executor &ex = default_executor())
+{
+    return read_awaitable(ex, dev);
+}
+
+/*!
+ * @brief  As above, with the options (poll_ms, alarm_pulses, alarm_cb,
+ *         alarm_ctx) of a zero-initialised lmt_read_t.
+ */
+inline read_awaitable read(const lmt01_dev_t *dev, const lmt_read_t &opts,
+                           executor &ex = default_executor())
+{
+    return read_awaitable(ex, dev, opts);
+}
+
+/*!
+ * @brief  Minimal fire-and-forget coroutine type for driving reads.
+ */
+struct task
+{
+    struct promise_type
+    {
+        task get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+} /* namespace lmt */
+
+#endif /* _LMT01_CORO_HPP_ */
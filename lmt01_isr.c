@@ -0,0 +1,107 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        lmt01_isr.c
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file lmt01_isr.c
+ * @brief Interrupt-driven software pulse counter.
+ */
+#include "lmt01_isr.h"
+
+
+/**
+  * @brief  Record a rising edge.
+  */
+void lmt_isr_edge(lmt_isr_counter_t *ctr, uint32_t now_us)
+{
+    if (!ctr->running)
+        return;
+
+    /* Ringing: too soon after the last real edge. Unsigned difference
+       copes with timestamp wrap. */
+    if (ctr->have_last && (uint32_t)(now_us - ctr->last_us) < ctr->min_interval_us)
+    {
+        ctr->glitches++;
+        return;
+    }
+
+    ctr->count++;
+    ctr->last_us = now_us;
+    ctr->have_last = 1;
+}
+
+/**
+  * @brief  Start counting edges.
+  * 
+  * @param[in,out] timer : Software pulse counter (lmt_isr_counter_t).
+  */
+void lmt_isr_start_timer(void *timer)
+{
+    lmt_isr_counter_t *ctr = timer;
+
+    ctr->running = 1;
+}
+
+/**
+  * @brief  Stop counting edges. Later edges are ignored, not tallied.
+  * 
+  * @param[in,out] timer : Software pulse counter (lmt_isr_counter_t).
+  */
+void lmt_isr_stop_timer(void *timer)
+{
+    lmt_isr_counter_t *ctr = timer;
+
+    ctr->running = 0;
+}
+
+/**
+  * @brief  Load the count. The next edge is accepted whatever its time,
+  *         since it starts a new window.
+  * 
+  * @param[in,out] timer : Software pulse counter (lmt_isr_counter_t).
+  * @param[in] cnt : Count to load.
+  */
+void lmt_isr_set_timer_cnt(void *timer, uint32_t *cnt)
+{
+    lmt_isr_counter_t *ctr = timer;
+
+    ctr->count = *cnt;
+    ctr->have_last = 0;
+}
+
+/**
+  * @brief  Read the count.
+  * 
+  * @param[in] timer : Software pulse counter (lmt_isr_counter_t).
+  * @param[out] cnt : Pulses counted.
+  */
+void lmt_isr_get_timer_cnt(void *timer, uint32_t *cnt)
+{
+    lmt_isr_counter_t *ctr = timer;
+
+    *cnt = ctr->count;
+}
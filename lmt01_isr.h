@@ -0,0 +1,94 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        lmt01_isr.h
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file lmt01_isr.h
+ * @brief Interrupt-driven software pulse counter. Stands in for a hardware
+ *        counter on boards that can only interrupt on the sensor pin: call
+ *        lmt_isr_edge() from the rising-edge interrupt and plug the HAL
+ *        functions below into the device structure, with the counter as
+ *        the timer context.
+ */
+
+#ifndef _LMT01_ISR_H_
+#define _LMT01_ISR_H_
+
+/*! CPP guard */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/*!
+ * @brief  Software pulse counter
+ */
+typedef struct
+{
+    /* Option: minimum time between accepted edges (us), 0 to disable.
+       Edges closer than this to the last accepted edge are glitches. */
+    uint32_t min_interval_us;
+
+    /* Pulses counted */
+    volatile uint32_t count;
+
+    /* Edges rejected by the min_interval_us filter */
+    volatile uint32_t glitches;
+
+    /* Time of the last accepted edge (us) */
+    volatile uint32_t last_us;
+
+    /* Counting enabled */
+    volatile uint8_t running;
+
+    /* last_us is valid */
+    volatile uint8_t have_last;
+
+} lmt_isr_counter_t;
+
+/**
+  * @brief  Record a rising edge. Call from the GPIO interrupt.
+  * 
+  * @param[in,out] ctr : Software pulse counter.
+  * @param[in] now_us : Free-running timestamp of the edge (us).
+  */
+void lmt_isr_edge(lmt_isr_counter_t *ctr, uint32_t now_us);
+
+/**
+  * @brief  HAL functions, usable directly as lmt01_dev_t function pointers
+  *         with timer pointing at an lmt_isr_counter_t.
+  */
+void lmt_isr_start_timer(void *timer);
+void lmt_isr_stop_timer(void *timer);
+void lmt_isr_set_timer_cnt(void *timer, uint32_t *cnt);
+void lmt_isr_get_timer_cnt(void *timer, uint32_t *cnt);
+
+#ifdef __cplusplus
+}
+#endif /* End of CPP guard */
+#endif /* _LMT01_ISR_H_ */
@@ -0,0 +1,326 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        lmt01_sched.c
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file lmt01_sched.c
+ * @brief Deadline scheduler for sensors sharing one pulse counter.
+ */
+#include "lmt01_sched.h"
+#include <stddef.h>
+
+/*!
+ * @brief Time a has been reached at time now, wrap-safe
+ */
+#define REACHED(now, a)     ((int32_t)((now) - (a)) >= 0)
+
+/*!
+ * @brief This internal API returns the expected duration of a reading
+ * before any has been measured.
+ */
+static uint32_t default_est(const lmt01_dev_t *dev);
+
+/*!
+ * @brief This internal API tells whether a pending job started after
+ * wait_ms would still meet its deadline.
+ */
+static uint8_t feasible(const lmt_sched_task_t *task, uint32_t now, uint32_t wait_ms);
+
+/*!
+ * @brief This internal API picks the pending job to run next.
+ */
+static lmt_sched_task_t *pick(lmt_sched_t *sched, uint32_t now);
+
+/*!
+ * @brief This internal API returns the pending job with the earliest
+ * deadline among those with priority above the given one (-1 for all).
+ */
+static lmt_sched_task_t *edf_first(lmt_sched_t *sched, int16_t above);
+
+/*!
+ * @brief This internal API tells whether every pending job meets its deadline.
+ */
+static uint8_t edf_fits(lmt_sched_t *sched, uint32_t start);
+
+/*!
+ * @brief This internal API accounts for the completed reading.
+ */
+static void complete(lmt_sched_t *sched, uint32_t now, lmt_status_t rslt);
+
+
+/**
+  * @brief  Initialise a scheduler.
+  */
+lmt_status_t lmt_sched_init(lmt_sched_t *sched, lmt_sched_task_t *tasks, uint32_t n, uint32_t now_ms)
+{
+    uint32_t i;
+
+    if (sched == NULL || tasks == NULL)
+        return LMT_E_NULL_PTR;
+
+    for (i = 0; i < n; i++)
+    {
+        if (tasks[i].dev == NULL)
+            return LMT_E_NULL_PTR;
+
+        if (tasks[i].period_ms == 0)
+            return LMT_E_INVALID;
+    }
+
+    sched->tasks = tasks;
+    sched->n = n;
+    sched->running = NULL;
+    sched->rd = (lmt_read_t){0};
+
+    for (i = 0; i < n; i++)
+    {
+        tasks[i].released = 0;
+        tasks[i].done = 0;
+        tasks[i].failed = 0;
+        tasks[i].misses = 0;
+        tasks[i].shed = 0;
+        tasks[i].pending = 0;
+        tasks[i].release_ms = now_ms;
+
+        if (tasks[i].est_ms == 0)
+            tasks[i].est_ms = default_est(tasks[i].dev);
+    }
+
+    return LMT_OK;
+}
+
+/**
+  * @brief  Release due jobs, advance the reading and start the next one.
+  */
+uint32_t lmt_sched_poll(lmt_sched_t *sched, uint32_t now_ms)
+{
+    lmt_sched_task_t *task;
+    lmt_status_t rslt;
+    uint32_t wait = UINT32_MAX;
+    uint32_t i;
+
+    if (sched->running != NULL && REACHED(now_ms, sched->step_ms))
+    {
+        rslt = lmt_read_step(&sched->rd);
+
+        if (rslt == LMT_BUSY)
+            sched->step_ms = now_ms + sched->rd.wait_ms;
+        else
+            complete(sched, now_ms, rslt);
+    }
+
+    for (i = 0; i < sched->n; i++)
+    {
+        task = &sched->tasks[i];
+
+        /* A job still waiting at the next release is dropped for it */
+        while (REACHED(now_ms, task->release_ms))
+        {
+            if (task->pending)
+            {
+                task->misses++;
+                task->shed++;
+            }
+
+            task->pending = 1;
+            task->job_deadline_ms = task->release_ms +
+                                    (task->deadline_ms != 0 ? task->deadline_ms : task->period_ms);
+            task->released++;
+            task->release_ms += task->period_ms;
+        }
+
+        /* Shed jobs that can no longer make it */
+        if (task->pending && !feasible(task, now_ms, 0))
+        {
+            task->pending = 0;
+            task->misses++;
+            task->shed++;
+        }
+    }
+
+    while (sched->running == NULL && (task = pick(sched, now_ms)) != NULL)
+    {
+        task->pending = 0;
+        sched->running = task;
+        sched->start_ms = now_ms;
+        sched->deadline_ms = task->job_deadline_ms;
+
+        rslt = lmt_read_start(task->dev, &sched->rd);
+
+        if (rslt == LMT_BUSY)
+            sched->step_ms = now_ms + sched->rd.wait_ms;
+        else
+            complete(sched, now_ms, rslt);
+    }
+
+    if (sched->running != NULL)
+        wait = sched->step_ms - now_ms;
+
+    for (i = 0; i < sched->n; i++)
+    {
+        if (sched->tasks[i].release_ms - now_ms < wait)
+            wait = sched->tasks[i].release_ms - now_ms;
+    }
+
+    return wait;
+}
+
+/*!
+ * @brief This internal API returns the expected duration of a reading.
+ */
+static uint32_t default_est(const lmt01_dev_t *dev)
+{
+    if (dev->state != NULL && (dev->state->flags & LMT_STATE_TIMED))
+        return dev->state->timing.drain_ms + dev->state->timing.capture_ms;
+
+    return LMT_DRAIN_PERIOD_MS + LMT_CAPTURE_PERIOD_MS;
+}
+
+/*!
+ * @brief This internal API tells whether a pending job would meet its deadline.
+ */
+static uint8_t feasible(const lmt_sched_task_t *task, uint32_t now, uint32_t wait_ms)
+{
+    return REACHED(task->job_deadline_ms, now + wait_ms + task->est_ms);
+}
+
+/*!
+ * @brief This internal API picks the pending job to run next.
+ */
+static lmt_sched_task_t *pick(lmt_sched_t *sched, uint32_t now)
+{
+    lmt_sched_task_t *cand = edf_first(sched, -1);
+    uint8_t top = 0;
+    uint32_t i;
+
+    if (cand == NULL || edf_fits(sched, now))
+        return cand;
+
+    /* Overloaded, something will miss: make it the less important jobs.
+       Readings cannot be pre-empted, so waiting until a critical job is
+       only just feasible would leave it at the mercy of one overrun. */
+    for (i = 0; i < sched->n; i++)
+    {
+        if (sched->tasks[i].pending && sched->tasks[i].priority > top)
+            top = sched->tasks[i].priority;
+    }
+
+    return edf_first(sched, (int16_t)top - 1);
+}
+
+/*!
+ * @brief This internal API returns the pending job with the earliest deadline.
+ */
+static lmt_sched_task_t *edf_first(lmt_sched_t *sched, int16_t above)
+{
+    lmt_sched_task_t *first = NULL;
+    lmt_sched_task_t *task;
+    uint32_t i;
+
+    /* Ties go to the higher priority */
+    for (i = 0; i < sched->n; i++)
+    {
+        task = &sched->tasks[i];
+
+        if (!task->pending || task->priority <= above)
+            continue;
+
+        if (first == NULL || (int32_t)(task->job_deadline_ms - first->job_deadline_ms) < 0 ||
+            (task->job_deadline_ms == first->job_deadline_ms && task->priority > first->priority))
+            first = task;
+    }
+
+    return first;
+}
+
+/*!
+ * @brief This internal API tells whether every pending job meets its deadline.
+ */
+static uint8_t edf_fits(lmt_sched_t *sched, uint32_t start)
+{
+    lmt_sched_task_t *task, *next, *last = NULL;
+    uint32_t t = start;
+    uint32_t i;
+
+    /* Walk the jobs in deadline order, ties in task order */
+    for (;;)
+    {
+        next = NULL;
+
+        for (i = 0; i < sched->n; i++)
+        {
+            task = &sched->tasks[i];
+
+            if (!task->pending)
+                continue;
+
+            /* Not yet walked */
+            if (last != NULL && ((int32_t)(task->job_deadline_ms - last->job_deadline_ms) < 0 ||
+                (task->job_deadline_ms == last->job_deadline_ms && task <= last)))
+                continue;
+
+            if (next == NULL || (int32_t)(task->job_deadline_ms - next->job_deadline_ms) < 0)
+                next = task;
+        }
+
+        if (next == NULL)
+            return 1;
+
+        t += next->est_ms;
+
+        if (!REACHED(next->job_deadline_ms, t))
+            return 0;
+
+        last = next;
+    }
+}
+
+/*!
+ * @brief This internal API accounts for the completed reading.
+ */
+static void complete(lmt_sched_t *sched, uint32_t now, lmt_status_t rslt)
+{
+    lmt_sched_task_t *task = sched->running;
+    uint8_t late = !REACHED(sched->deadline_ms, now);
+
+    /* Running average over ~4 readings, rounded up. A failed reading
+       may end early and says nothing about the next one's length. */
+    if (rslt == LMT_OK)
+        task->est_ms = (task->est_ms * 3 + (now - sched->start_ms) + 3) / 4;
+
+    if (late)
+        task->misses++;
+    else if (rslt != LMT_OK)
+        task->failed++;
+    else
+        task->done++;
+
+    sched->running = NULL;
+
+    if (task->done_cb != NULL)
+        task->done_cb(task->done_ctx, rslt, (rslt == LMT_OK) ? sched->rd.pulses : 0, late);
+}
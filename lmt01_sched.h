@@ -0,0 +1,149 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        lmt01_sched.h
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file lmt01_sched.h
+ * @brief Deadline scheduler for sensors sharing one pulse counter. Only one
+ *        reading runs at a time. Each sensor releases a job every period,
+ *        and jobs run earliest deadline first. When the pending jobs can no
+ *        longer all meet their deadlines, the highest priority ones run
+ *        first. Jobs that can no longer finish in time are shed, so under
+ *        overload the low priority sensors lose readings first.
+ */
+
+#ifndef _LMT01_SCHED_H_
+#define _LMT01_SCHED_H_
+
+/*! CPP guard */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "lmt01.h"
+
+/*!
+ * @brief  Reading completion callback. late is non-zero if the reading
+ *         finished after its deadline.
+ */
+typedef void (*lmt_sched_done_fptr_t)(void *ctx, lmt_status_t rslt, uint32_t pulses, uint8_t late);
+
+/*!
+ * @brief  Periodic sensor task. Zero-initialise, then set the options.
+ */
+typedef struct
+{
+    /* Option: device read by this task */
+    const lmt01_dev_t *dev;
+
+    /* Option: release period (ms) */
+    uint32_t period_ms;
+
+    /* Option: deadline after release (ms), 0 for period_ms */
+    uint32_t deadline_ms;
+
+    /* Option: priority, higher is more important */
+    uint8_t priority;
+
+    /* Option: called as each reading completes */
+    lmt_sched_done_fptr_t done_cb;
+
+    /* Option: context passed to done_cb */
+    void *done_ctx;
+
+    /* Jobs released, completed in time, finished in time with an error,
+       missed, and of those missed, shed without running */
+    uint32_t released;
+    uint32_t done;
+    uint32_t failed;
+    uint32_t misses;
+    uint32_t shed;
+
+    /* Expected reading duration (ms), learnt from completed readings */
+    uint32_t est_ms;
+
+    /* Next release, and deadline of the pending job (ms) */
+    uint32_t release_ms;
+    uint32_t job_deadline_ms;
+
+    /* A job is waiting to run */
+    uint8_t pending;
+
+} lmt_sched_task_t;
+
+/*!
+ * @brief  Scheduler
+ */
+typedef struct
+{
+    /* Tasks */
+    lmt_sched_task_t *tasks;
+    uint32_t n;
+
+    /* Task whose reading is in progress, or NULL */
+    lmt_sched_task_t *running;
+
+    /* Reading in progress */
+    lmt_read_t rd;
+
+    /* Start, deadline and next step of the reading in progress (ms) */
+    uint32_t start_ms;
+    uint32_t deadline_ms;
+    uint32_t step_ms;
+
+} lmt_sched_t;
+
+/**
+  * @brief  Initialise a scheduler. Every task releases its first job
+  *         at now_ms.
+  * 
+  * @param[out] sched : Scheduler.
+  * @param[in,out] tasks : Tasks, options filled in.
+  * @param[in] n : Number of tasks.
+  * @param[in] now_ms : Current time (ms).
+  * 
+  * @return result of API execution status
+  * @retval LMT_E_INVALID if a period is 0
+  */
+lmt_status_t lmt_sched_init(lmt_sched_t *sched, lmt_sched_task_t *tasks, uint32_t n, uint32_t now_ms);
+
+/**
+  * @brief  Release due jobs, advance the reading in progress and start
+  *         the next one. Call at least as often as it asks.
+  * 
+  * @param[in,out] sched : Scheduler.
+  * @param[in] now_ms : Current time (ms), may wrap.
+  * 
+  * @return Time until the next call is needed (ms)
+  */
+uint32_t lmt_sched_poll(lmt_sched_t *sched, uint32_t now_ms);
+
+#ifdef __cplusplus
+}
+#endif /* End of CPP guard */
+#endif /* _LMT01_SCHED_H_ */
@@ -0,0 +1,466 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        lmt01_vcd.c
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file lmt01_vcd.c
+ * @brief Offline decoder for logic analyzer captures in VCD format.
+ */
+#include "lmt01_vcd.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TOKEN_LEN   64
+
+/*!
+ * @brief  Buffered reader over the capture
+ */
+typedef struct
+{
+    FILE *f;
+    size_t len;
+    size_t pos;
+    char buf[LMT_VCD_BUF_LEN];
+} reader_t;
+
+/*!
+ * @brief  Decoder state
+ */
+typedef struct
+{
+    const lmt_vcd_opts_t *opts;
+    lmt_vcd_stats_t *stats;
+
+    /* Timescale: ps = t * num / den */
+    uint64_t num;
+    uint64_t den;
+
+    /* Current time (ps) and capture start */
+    uint64_t now;
+    uint64_t start;
+    uint8_t started;
+
+    /* Signal level */
+    uint8_t level;
+
+    /* Burst in progress */
+    uint32_t pulses;
+    uint64_t last_edge;
+    uint8_t have_edge;
+
+    /* The burst in progress was preceded by a full gap */
+    uint8_t clean;
+
+} decoder_t;
+
+/*!
+ * @brief This internal API checks for VCD token separators.
+ */
+static inline int is_space(char c);
+
+/*!
+ * @brief This internal API refills the read buffer.
+ *
+ * @return Bytes read, 0 at end of input.
+ */
+static size_t refill(reader_t *r);
+
+/*!
+ * @brief This internal API reads the next whitespace-separated token,
+ * truncated to TOKEN_LEN - 1 characters.
+ *
+ * @return Token length, 0 at end of input.
+ */
+static size_t next_token(reader_t *r, char *tok);
+
+/*!
+ * @brief This internal API skips tokens up to and including $end.
+ */
+static void skip_to_end(reader_t *r, char *tok);
+
+/*!
+ * @brief This internal API parses a decimal timestamp.
+ */
+static inline uint64_t parse_u64(const char *s);
+
+/*!
+ * @brief This internal API parses the body of a $timescale section.
+ */
+static lmt_status_t parse_timescale(reader_t *r, decoder_t *d, char *tok);
+
+/*!
+ * @brief This internal API handles a change of the sensor signal level.
+ */
+static void on_level(decoder_t *d, uint8_t level);
+
+/*!
+ * @brief This internal API reports the burst in progress if it is complete.
+ */
+static void end_burst(decoder_t *d, uint8_t clean_end);
+
+
+/**
+  * @brief  Decode every reading in a VCD capture.
+  */
+lmt_status_t lmt_vcd_decode(FILE *in, const lmt_vcd_opts_t *opts, lmt_vcd_stats_t *stats)
+{
+    lmt_vcd_stats_t local;
+    char tok[TOKEN_LEN];
+    char id[TOKEN_LEN] = {0};
+    size_t id_len = 0;
+    size_t n;
+    uint8_t in_header = 1;
+    decoder_t d;
+
+    if (in == NULL || opts == NULL)
+        return LMT_E_NULL_PTR;
+
+    reader_t *r = malloc(sizeof(reader_t));
+    if (r == NULL)
+        return LMT_E_NO_MEM;
+
+    r->f = in;
+    r->len = 0;
+    r->pos = 0;
+
+    if (stats == NULL)
+        stats = &local;
+
+    memset(stats, 0, sizeof(*stats));
+    memset(&d, 0, sizeof(d));
+    d.opts = opts;
+    d.stats = stats;
+    d.num = 1;
+    d.den = 1;
+
+    lmt_status_t rslt = LMT_OK;
+
+    while (rslt == LMT_OK && (n = next_token(r, tok)) != 0)
+    {
+        /* Value changes and timestamps first, they are nearly all of it */
+        if (!in_header)
+        {
+            switch (tok[0])
+            {
+                case '#':
+                    d.now = parse_u64(tok + 1) * d.num;
+
+                    if (d.den != 1)
+                        d.now /= d.den;
+
+                    if (!d.started)
+                    {
+                        d.start = d.now;
+                        d.started = 1;
+                    }
+                    continue;
+
+                case '0': case '1': case 'x': case 'X': case 'z': case 'Z':
+                    if (n - 1 == id_len && memcmp(tok + 1, id, id_len) == 0)
+                        on_level(&d, tok[0] == '1');
+                    continue;
+
+                case 'b': case 'B': case 'r': case 'R':
+                {
+                    char last = tok[n - 1];
+
+                    if (next_token(r, tok) == id_len && memcmp(tok, id, id_len) == 0)
+                        on_level(&d, last == '1');
+                    continue;
+                }
+
+                default:
+                    break;
+            }
+        }
+
+        if (tok[0] == '$')
+        {
+            if (strcmp(tok, "$timescale") == 0)
+            {
+                rslt = parse_timescale(r, &d, tok);
+            }
+            else if (strcmp(tok, "$var") == 0)
+            {
+                char size[TOKEN_LEN];
+                char code[TOKEN_LEN];
+
+                /* $var type size id reference [range] $end */
+                next_token(r, tok);
+                next_token(r, size);
+                next_token(r, code);
+                next_token(r, tok);
+
+                if (id[0] == '\0' && (opts->signal != NULL ? strcmp(tok, opts->signal) == 0
+                                                           : strcmp(size, "1") == 0))
+                {
+                    strcpy(id, code);
+                    id_len = strlen(id);
+                }
+
+                if (strcmp(tok, "$end") != 0)
+                    skip_to_end(r, tok);
+            }
+            else if (strcmp(tok, "$enddefinitions") == 0)
+            {
+                skip_to_end(r, tok);
+                in_header = 0;
+
+                if (id[0] == '\0')
+                    rslt = LMT_E_DEV_NOT_FOUND;
+            }
+            else if (strcmp(tok, "$dumpvars") == 0 || strcmp(tok, "$dumpall") == 0 ||
+                     strcmp(tok, "$dumpon") == 0 || strcmp(tok, "$dumpoff") == 0 ||
+                     strcmp(tok, "$end") == 0)
+            {
+                /* Value changes inside are handled like any other */
+            }
+            else
+            {
+                /* $comment, $date, $version, $scope, $upscope, ... */
+                skip_to_end(r, tok);
+            }
+        }
+    }
+
+    if (rslt == LMT_OK && in_header)
+        rslt = (id[0] == '\0') ? LMT_E_DEV_NOT_FOUND : LMT_E_INVALID;
+
+    if (rslt == LMT_OK)
+    {
+        /* Last burst is only complete if the gap after it was captured */
+        stats->end_ps = d.now;
+        end_burst(&d, d.have_edge && (d.now - d.last_edge) >= (opts->gap_ns ? opts->gap_ns : LMT_VCD_GAP_NS) * 1000);
+    }
+
+    free(r);
+
+    return rslt;
+}
+
+/*!
+ * @brief This internal API checks for VCD token separators.
+ */
+static inline int is_space(char c)
+{
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+/*!
+ * @brief This internal API refills the read buffer.
+ */
+static size_t refill(reader_t *r)
+{
+    r->len = fread(r->buf, 1, sizeof(r->buf), r->f);
+    r->pos = 0;
+
+    return r->len;
+}
+
+/*!
+ * @brief This internal API reads the next token. Tokens are scanned in
+ * place in the read buffer and only copied out, so the common case costs
+ * one pass over the bytes.
+ */
+static size_t next_token(reader_t *r, char *tok)
+{
+    size_t n = 0;
+
+    for (;;)
+    {
+        if (r->pos == r->len && refill(r) == 0)
+            break;
+
+        const char *p = r->buf + r->pos;
+        const char *end = r->buf + r->len;
+
+        /* Leading whitespace, possibly spanning refills */
+        if (n == 0)
+        {
+            while (p < end && is_space(*p))
+                p++;
+
+            if (p == end)
+            {
+                r->pos = r->len;
+                continue;
+            }
+        }
+
+        const char *start = p;
+
+        while (p < end && !is_space(*p))
+            p++;
+
+        size_t len = (size_t)(p - start);
+
+        if (len > TOKEN_LEN - 1 - n)
+            len = TOKEN_LEN - 1 - n;
+
+        memcpy(tok + n, start, len);
+        n += len;
+        r->pos = (size_t)(p - r->buf);
+
+        /* Stopped on whitespace rather than the end of the buffer */
+        if (p < end)
+            break;
+    }
+
+    tok[n] = '\0';
+
+    return n;
+}
+
+/*!
+ * @brief This internal API skips tokens up to and including $end.
+ */
+static void skip_to_end(reader_t *r, char *tok)
+{
+    while (next_token(r, tok) != 0 && strcmp(tok, "$end") != 0);
+}
+
+/*!
+ * @brief This internal API parses a decimal timestamp.
+ */
+static inline uint64_t parse_u64(const char *s)
+{
+    uint64_t v = 0;
+
+    while (*s >= '0' && *s <= '9')
+        v = v * 10 + (uint64_t)(*s++ - '0');
+
+    return v;
+}
+
+/*!
+ * @brief This internal API parses the body of a $timescale section,
+ * e.g. "1ns" or "100 ps".
+ */
+static lmt_status_t parse_timescale(reader_t *r, decoder_t *d, char *tok)
+{
+    char text[TOKEN_LEN] = {0};
+    char *unit;
+
+    /* Join the tokens, the number and unit may be split */
+    while (next_token(r, tok) != 0 && strcmp(tok, "$end") != 0)
+    {
+        if (strlen(text) + strlen(tok) < sizeof(text))
+            strcat(text, tok);
+    }
+
+    uint64_t mult = strtoull(text, &unit, 10);
+
+    if (mult == 0)
+        return LMT_E_INVALID;
+
+    d->den = 1;
+
+    if (strcmp(unit, "s") == 0)
+        d->num = mult * 1000000000000ULL;
+    else if (strcmp(unit, "ms") == 0)
+        d->num = mult * 1000000000ULL;
+    else if (strcmp(unit, "us") == 0)
+        d->num = mult * 1000000ULL;
+    else if (strcmp(unit, "ns") == 0)
+        d->num = mult * 1000ULL;
+    else if (strcmp(unit, "ps") == 0)
+        d->num = mult;
+    else if (strcmp(unit, "fs") == 0)
+    {
+        d->num = mult;
+        d->den = 1000;
+    }
+    else
+        return LMT_E_INVALID;
+
+    return LMT_OK;
+}
+
+/*!
+ * @brief This internal API handles a change of the sensor signal level.
+ */
+static void on_level(decoder_t *d, uint8_t level)
+{
+    const lmt_vcd_opts_t *opts = d->opts;
+    uint64_t gap = (opts->gap_ns ? opts->gap_ns : LMT_VCD_GAP_NS) * 1000;
+    uint64_t min_interval = opts->min_interval_ns * 1000;
+    uint8_t rising = level && !d->level;
+
+    d->level = level;
+
+    if (!rising)
+        return;
+
+    /* Ringing: too soon after the last accepted edge */
+    if (d->have_edge && (d->now - d->last_edge) < min_interval)
+    {
+        d->stats->glitches++;
+        return;
+    }
+
+    /* Quiet long enough: the previous burst is over */
+    if (d->have_edge && (d->now - d->last_edge) >= gap)
+        end_burst(d, 1);
+
+    /* A burst is only complete if a full gap was seen before it, either
+       after the previous burst or from the start of the capture. */
+    if (d->pulses == 0)
+        d->clean = d->have_edge || (d->now - d->start) >= gap;
+
+    d->pulses++;
+    d->last_edge = d->now;
+    d->have_edge = 1;
+    d->stats->edges++;
+}
+
+/*!
+ * @brief This internal API reports the burst in progress if complete.
+ */
+static void end_burst(decoder_t *d, uint8_t clean_end)
+{
+    if (d->pulses == 0)
+        return;
+
+    if (d->clean && clean_end)
+    {
+        d->stats->readings++;
+
+        if (d->opts->out != NULL)
+            fprintf(d->opts->out, "%llu.%012llu,%lu,%.3f\n",
+                    (unsigned long long)(d->last_edge / 1000000000000ULL),
+                    (unsigned long long)(d->last_edge % 1000000000000ULL),
+                    (unsigned long)d->pulses,
+                    lmt_pulses_to_temperature(d->pulses, d->opts->conv));
+    }
+    else
+    {
+        d->stats->partial++;
+    }
+
+    d->pulses = 0;
+}
@@ -0,0 +1,120 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        lmt01_vcd.h
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file lmt01_vcd.h
+ * @brief Offline decoder for logic analyzer captures in VCD format. Edges
+ *        of one signal are split into bursts by quiet gaps, as the gap
+ *        timer does, and deglitched by the minimum edge interval rule of
+ *        lmt_isr_edge(). The decoder has its own copy of both, at the
+ *        capture's resolution rather than in us; only the conversion is
+ *        the driver's. The capture is streamed, so its size is not
+ *        limited by memory.
+ */
+
+#ifndef _LMT01_VCD_H_
+#define _LMT01_VCD_H_
+
+/*! CPP guard */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include "lmt01.h"
+
+/*!
+ * @brief Defaults
+ */
+#define LMT_VCD_GAP_NS      1000000 /* LMT_GAP_MS */
+#define LMT_VCD_BUF_LEN     65536   /* Read buffer (bytes) */
+
+/*!
+ * @brief  Decoder options
+ */
+typedef struct
+{
+    /* Reference name of the sensor signal in the $var declaration.
+       NULL selects the first 1-bit variable. */
+    const char *signal;
+
+    /* Quiet time that ends a burst (ns), 0 for LMT_VCD_GAP_NS */
+    uint64_t gap_ns;
+
+    /* Minimum time between accepted edges (ns), 0 to disable */
+    uint64_t min_interval_ns;
+
+    /* Conversion type for the reported temperature */
+    lmt_conv_t conv;
+
+    /* Where readings are written as "time_s,pulses,temp_c" lines, or NULL */
+    FILE *out;
+
+} lmt_vcd_opts_t;
+
+/*!
+ * @brief  Decoder results
+ */
+typedef struct
+{
+    /* Complete bursts decoded */
+    uint32_t readings;
+
+    /* Bursts cut off by the start or end of the capture, not reported */
+    uint32_t partial;
+
+    /* Rising edges accepted */
+    uint64_t edges;
+
+    /* Rising edges rejected by min_interval_ns */
+    uint64_t glitches;
+
+    /* Capture end time (ps) */
+    uint64_t end_ps;
+
+} lmt_vcd_stats_t;
+
+/**
+  * @brief  Decode every reading in a VCD capture.
+  * 
+  * @param[in] in : VCD stream.
+  * @param[in] opts : Decoder options.
+  * @param[out] stats : Decoder results, may be NULL.
+  * 
+  * @return result of API execution status
+  * @retval LMT_E_DEV_NOT_FOUND if the signal is not declared,
+  *         LMT_E_INVALID if the header cannot be parsed,
+  *         LMT_E_NO_MEM if the read buffer cannot be allocated.
+  */
+lmt_status_t lmt_vcd_decode(FILE *in, const lmt_vcd_opts_t *opts, lmt_vcd_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif /* End of CPP guard */
+#endif /* _LMT01_VCD_H_ */
@@ -0,0 +1,402 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        lmt01_wheel.c
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file lmt01_wheel.c
+ * @brief Hierarchical timing wheel.
+ *
+ * Level 0 has one slot per tick. A slot of level l covers one turn of
+ * level l - 1 and is cascaded, its entries re-queued one level down, as
+ * the tick enters it. An entry is queued on the lowest level that reaches
+ * its expiry, so each one is touched at most LMT_WHEEL_LEVELS times.
+ */
+#include "lmt01_wheel.h"
+#include <stddef.h>
+
+#define SLOT_MASK   (LMT_WHEEL_SLOTS - 1)
+
+/*!
+ * @brief This internal API queues an entry by its expiry.
+ */
+static void slot_insert(lmt_wheel_t *wheel, lmt_wheel_entry_t *entry);
+
+/*!
+ * @brief This internal API unlinks a queued entry.
+ */
+static void slot_unlink(lmt_wheel_t *wheel, lmt_wheel_entry_t *entry);
+
+/*!
+ * @brief This internal API re-queues the entries of the current slot of a
+ * level one level down.
+ */
+static void cascade(lmt_wheel_t *wheel, uint32_t level);
+
+/*!
+ * @brief This internal API runs the entries of the current level 0 slot.
+ */
+static uint32_t expire(lmt_wheel_t *wheel);
+
+/*!
+ * @brief This internal API steps a reader's acquisition on expiry.
+ */
+static void reader_fire(lmt_wheel_entry_t *entry);
+
+/*!
+ * @brief This internal API returns the index of the lowest set bit.
+ */
+static inline uint32_t ctz64(uint64_t x);
+
+
+/**
+  * @brief  Initialise an empty wheel.
+  */
+void lmt_wheel_init(lmt_wheel_t *wheel, uint32_t now_ms)
+{
+    uint32_t l, i;
+
+    wheel->now = now_ms;
+    wheel->count = 0;
+
+    for (l = 0; l < LMT_WHEEL_LEVELS; l++)
+    {
+        wheel->occupied[l] = 0;
+
+        for (i = 0; i < LMT_WHEEL_SLOTS; i++)
+            wheel->slots[l][i] = NULL;
+    }
+}
+
+/**
+  * @brief  Queue an entry delay_ms after the current tick.
+  */
+lmt_status_t lmt_wheel_add(lmt_wheel_t *wheel, lmt_wheel_entry_t *entry, uint32_t delay_ms)
+{
+    if (wheel == NULL || entry == NULL)
+        return LMT_E_NULL_PTR;
+
+    if (delay_ms > LMT_WHEEL_MAX_MS)
+        return LMT_E_INVALID;
+
+    if (entry->prev != NULL)
+        slot_unlink(wheel, entry);
+
+    /* The current tick has been processed already */
+    entry->expiry = wheel->now + (delay_ms != 0 ? delay_ms : 1);
+    slot_insert(wheel, entry);
+    wheel->count++;
+
+    return LMT_OK;
+}
+
+/**
+  * @brief  Remove an entry if queued.
+  */
+void lmt_wheel_cancel(lmt_wheel_t *wheel, lmt_wheel_entry_t *entry)
+{
+    if (entry->prev != NULL)
+        slot_unlink(wheel, entry);
+}
+
+/**
+  * @brief  Advance the wheel to now_ms.
+  */
+uint32_t lmt_wheel_advance(lmt_wheel_t *wheel, uint32_t now_ms)
+{
+    uint32_t fired = 0;
+    uint32_t next, off, l;
+    uint64_t bits;
+
+    while ((int32_t)(now_ms - wheel->now) > 0)
+    {
+        if (wheel->count == 0)
+        {
+            wheel->now = now_ms;
+            break;
+        }
+
+        /* Skip to the next occupied level 0 slot of this turn, or to
+           the end of the turn if there is none */
+        next = wheel->now + 1;
+        off = next & SLOT_MASK;
+
+        if (off != 0)
+        {
+            bits = wheel->occupied[0] >> off;
+            next = (bits != 0) ? next + ctz64(bits) : (wheel->now | SLOT_MASK) + 1;
+        }
+
+        if ((int32_t)(next - now_ms) > 0)
+        {
+            wheel->now = now_ms;
+            break;
+        }
+
+        wheel->now = next;
+
+        /* Entering a new slot of a coarser level: bring it down, highest
+           first so its entries can cascade again in the same tick */
+        for (l = LMT_WHEEL_LEVELS - 1; l >= 1; l--)
+        {
+            if ((wheel->now & ((1ul << (LMT_WHEEL_BITS * l)) - 1)) == 0)
+                cascade(wheel, l);
+        }
+
+        fired += expire(wheel);
+    }
+
+    return fired;
+}
+
+/**
+  * @brief  Time until the wheel next has work.
+  */
+uint32_t lmt_wheel_next(const lmt_wheel_t *wheel)
+{
+    uint32_t best = UINT32_MAX;
+    uint32_t off, cur, shift, d, l;
+    uint64_t bits;
+
+    if (wheel->count == 0)
+        return UINT32_MAX;
+
+    /* Level 0: this turn from the next tick, else the next turn */
+    off = (wheel->now + 1) & SLOT_MASK;
+    bits = wheel->occupied[0];
+
+    if (off != 0 && (bits >> off) != 0)
+        best = 1 + ctz64(bits >> off);
+    else if (bits != 0)
+        best = (SLOT_MASK - (wheel->now & SLOT_MASK)) + 1 + ctz64(bits);
+
+    /* Coarser levels: when the next occupied slot is cascaded */
+    for (l = 1; l < LMT_WHEEL_LEVELS; l++)
+    {
+        bits = wheel->occupied[l];
+
+        if (bits == 0)
+            continue;
+
+        shift = LMT_WHEEL_BITS * l;
+        cur = ((wheel->now >> shift) + 1) & SLOT_MASK;
+
+        /* Rotate so the slot after the current one is bit 0 */
+        if (cur != 0)
+            bits = (bits >> cur) | (bits << (LMT_WHEEL_SLOTS - cur));
+
+        d = ((((wheel->now >> shift) + 1 + ctz64(bits)) << shift) - wheel->now);
+
+        if (d < best)
+            best = d;
+    }
+
+    return best;
+}
+
+/**
+  * @brief  Start reading a device periodically.
+  */
+lmt_status_t lmt_wheel_reader_start(lmt_wheel_t *wheel, lmt_wheel_reader_t *rdr,
+                                    const lmt01_dev_t *dev, uint32_t delay_ms)
+{
+    if (wheel == NULL || rdr == NULL || dev == NULL)
+        return LMT_E_NULL_PTR;
+
+    rdr->wheel = wheel;
+    rdr->dev = dev;
+    rdr->rd.state = LMT_READ_IDLE;
+    rdr->entry.cb = reader_fire;
+    rdr->entry.ctx = rdr;
+
+    return lmt_wheel_add(wheel, &rdr->entry, delay_ms);
+}
+
+/**
+  * @brief  Stop a reader.
+  */
+void lmt_wheel_reader_stop(lmt_wheel_reader_t *rdr)
+{
+    if (rdr->wheel != NULL)
+        lmt_wheel_cancel(rdr->wheel, &rdr->entry);
+
+    rdr->wheel = NULL;
+    rdr->rd.state = LMT_READ_IDLE;
+}
+
+/*!
+ * @brief This internal API queues an entry by its expiry.
+ */
+static void slot_insert(lmt_wheel_t *wheel, lmt_wheel_entry_t *entry)
+{
+    uint32_t delta = entry->expiry - wheel->now;
+    uint32_t l = 0;
+    uint32_t idx;
+
+    while (l < LMT_WHEEL_LEVELS - 1 && (delta >> (LMT_WHEEL_BITS * (l + 1))) != 0)
+        l++;
+
+    idx = (entry->expiry >> (LMT_WHEEL_BITS * l)) & SLOT_MASK;
+
+    entry->slot = (uint16_t)(l * LMT_WHEEL_SLOTS + idx);
+    entry->next = wheel->slots[l][idx];
+    entry->prev = &wheel->slots[l][idx];
+
+    if (entry->next != NULL)
+        entry->next->prev = &entry->next;
+
+    wheel->slots[l][idx] = entry;
+    wheel->occupied[l] |= (uint64_t)1 << idx;
+}
+
+/*!
+ * @brief This internal API unlinks a queued entry.
+ */
+static void slot_unlink(lmt_wheel_t *wheel, lmt_wheel_entry_t *entry)
+{
+    uint32_t l = entry->slot / LMT_WHEEL_SLOTS;
+    uint32_t idx = entry->slot % LMT_WHEEL_SLOTS;
+
+    *entry->prev = entry->next;
+
+    if (entry->next != NULL)
+        entry->next->prev = entry->prev;
+
+    if (wheel->slots[l][idx] == NULL)
+        wheel->occupied[l] &= ~((uint64_t)1 << idx);
+
+    entry->next = NULL;
+    entry->prev = NULL;
+    wheel->count--;
+}
+
+/*!
+ * @brief This internal API re-queues the current slot of a level one level down.
+ */
+static void cascade(lmt_wheel_t *wheel, uint32_t level)
+{
+    uint32_t idx = (wheel->now >> (LMT_WHEEL_BITS * level)) & SLOT_MASK;
+    lmt_wheel_entry_t *entry = wheel->slots[level][idx];
+    lmt_wheel_entry_t *next;
+
+    wheel->slots[level][idx] = NULL;
+    wheel->occupied[level] &= ~((uint64_t)1 << idx);
+
+    for (; entry != NULL; entry = next)
+    {
+        next = entry->next;
+        slot_insert(wheel, entry);
+    }
+}
+
+/*!
+ * @brief This internal API runs the entries of the current level 0 slot.
+ */
+static uint32_t expire(lmt_wheel_t *wheel)
+{
+    uint32_t idx = wheel->now & SLOT_MASK;
+    lmt_wheel_entry_t *entry = wheel->slots[0][idx];
+    lmt_wheel_entry_t *next;
+    uint32_t fired = 0;
+
+    /* Detach the whole list first: callbacks may queue entries again */
+    wheel->slots[0][idx] = NULL;
+    wheel->occupied[0] &= ~((uint64_t)1 << idx);
+
+    for (; entry != NULL; entry = next)
+    {
+        next = entry->next;
+
+        if (next != NULL)
+            next->prev = &wheel->slots[0][idx];
+
+        entry->next = NULL;
+        entry->prev = NULL;
+        wheel->count--;
+        fired++;
+
+        entry->cb(entry);
+    }
+
+    return fired;
+}
+
+/*!
+ * @brief This internal API steps a reader's acquisition on expiry.
+ */
+static void reader_fire(lmt_wheel_entry_t *entry)
+{
+    lmt_wheel_reader_t *rdr = entry->ctx;
+    lmt_wheel_t *wheel = rdr->wheel;
+    lmt_status_t rslt;
+    uint32_t elapsed;
+
+    if (rdr->rd.state == LMT_READ_DRAIN || rdr->rd.state == LMT_READ_CAPTURE)
+    {
+        rslt = lmt_read_step(&rdr->rd);
+    }
+    else
+    {
+        rdr->start_ms = wheel->now;
+        rslt = lmt_read_start(rdr->dev, &rdr->rd);
+    }
+
+    if (rslt == LMT_BUSY)
+    {
+        lmt_wheel_add(wheel, entry, rdr->rd.wait_ms);
+        return;
+    }
+
+    if (rdr->done_cb != NULL)
+        rdr->done_cb(rdr->done_ctx, rslt, (rslt == LMT_OK) ? rdr->rd.pulses : 0);
+
+    /* Stopped from the callback, or a single reading */
+    if (rdr->wheel == NULL || rdr->period_ms == 0)
+        return;
+
+    elapsed = wheel->now - rdr->start_ms;
+    lmt_wheel_add(wheel, entry, (rdr->period_ms > elapsed) ? rdr->period_ms - elapsed : 0);
+}
+
+/*!
+ * @brief This internal API returns the index of the lowest set bit.
+ */
+static inline uint32_t ctz64(uint64_t x)
+{
+#if defined(__GNUC__)
+    return (uint32_t)__builtin_ctzll(x);
+#else
+    uint32_t n = 0;
+
+    while ((x & 1) == 0)
+    {
+        x >>= 1;
+        n++;
+    }
+
+    return n;
+#endif
+}
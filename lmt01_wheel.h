@@ -0,0 +1,219 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        lmt01_wheel.h
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file lmt01_wheel.h
+ * @brief Hierarchical timing wheel for driving many non-blocking readings
+ *        from one millisecond tick. Insert, cancel and expire are O(1)
+ *        regardless of the number of timers, and no memory is allocated:
+ *        each timer is an entry owned by the caller.
+ */
+
+#ifndef _LMT01_WHEEL_H_
+#define _LMT01_WHEEL_H_
+
+/*! CPP guard */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "lmt01.h"
+
+/*!
+ * @brief  Wheel geometry: LMT_WHEEL_LEVELS wheels of 2^LMT_WHEEL_BITS
+ *         slots, each slot of a level spanning a whole turn of the one
+ *         below. Delays up to LMT_WHEEL_MAX_MS are accepted.
+ */
+#define LMT_WHEEL_BITS      6
+#define LMT_WHEEL_SLOTS     (1u << LMT_WHEEL_BITS)
+#define LMT_WHEEL_LEVELS    4
+#define LMT_WHEEL_MAX_MS    ((1ul << (LMT_WHEEL_BITS * LMT_WHEEL_LEVELS)) - 1)
+
+typedef struct lmt_wheel_entry lmt_wheel_entry_t;
+
+/*!
+ * @brief  Expiry callback. May re-add or cancel any entry, itself included.
+ */
+typedef void (*lmt_wheel_fptr_t)(lmt_wheel_entry_t *entry);
+
+/*!
+ * @brief  Timer entry. Zero-initialise, then set cb and ctx.
+ */
+struct lmt_wheel_entry
+{
+    /* Called on expiry */
+    lmt_wheel_fptr_t cb;
+
+    /* Caller context */
+    void *ctx;
+
+    /* Expiry tick */
+    uint32_t expiry;
+
+    /* Slot list links, prev is NULL when not queued */
+    lmt_wheel_entry_t *next;
+    lmt_wheel_entry_t **prev;
+
+    /* Slot queued in, level * LMT_WHEEL_SLOTS + index */
+    uint16_t slot;
+};
+
+/*!
+ * @brief  Timing wheel
+ */
+typedef struct
+{
+    /* Last tick processed (ms) */
+    uint32_t now;
+
+    /* Entries queued */
+    uint32_t count;
+
+    /* Non-empty slots, one bit per slot */
+    uint64_t occupied[LMT_WHEEL_LEVELS];
+
+    /* Slot lists */
+    lmt_wheel_entry_t *slots[LMT_WHEEL_LEVELS][LMT_WHEEL_SLOTS];
+
+} lmt_wheel_t;
+
+/*!
+ * @brief  Reading completion callback
+ */
+typedef void (*lmt_wheel_done_fptr_t)(void *ctx, lmt_status_t rslt, uint32_t pulses);
+
+/*!
+ * @brief  Periodic non-blocking reader of one device, driven by a wheel.
+ *         Zero-initialise, then set the options.
+ */
+typedef struct
+{
+    /* Option: time from the start of one reading to the next (ms),
+       0 for a single reading */
+    uint32_t period_ms;
+
+    /* Option: called as each reading completes */
+    lmt_wheel_done_fptr_t done_cb;
+
+    /* Option: context passed to done_cb */
+    void *done_ctx;
+
+    /* Acquisition context; its options are used for every reading */
+    lmt_read_t rd;
+
+    /* Wheel timer */
+    lmt_wheel_entry_t entry;
+
+    /* Wheel and device being read */
+    lmt_wheel_t *wheel;
+    const lmt01_dev_t *dev;
+
+    /* Tick the current reading started at */
+    uint32_t start_ms;
+
+} lmt_wheel_reader_t;
+
+/**
+  * @brief  Initialise an empty wheel.
+  * 
+  * @param[out] wheel : Timing wheel.
+  * @param[in] now_ms : Current tick.
+  */
+void lmt_wheel_init(lmt_wheel_t *wheel, uint32_t now_ms);
+
+/**
+  * @brief  Queue an entry to expire delay_ms after the current tick, at
+  *         the earliest on the next one. Re-queues it if already queued.
+  * 
+  * @param[in,out] wheel : Timing wheel.
+  * @param[in,out] entry : Timer entry.
+  * @param[in] delay_ms : Delay (ms).
+  * 
+  * @return result of API execution status
+  * @retval LMT_E_INVALID if delay_ms exceeds LMT_WHEEL_MAX_MS
+  */
+lmt_status_t lmt_wheel_add(lmt_wheel_t *wheel, lmt_wheel_entry_t *entry, uint32_t delay_ms);
+
+/**
+  * @brief  Remove an entry if queued.
+  * 
+  * @param[in,out] wheel : Timing wheel.
+  * @param[in,out] entry : Timer entry.
+  */
+void lmt_wheel_cancel(lmt_wheel_t *wheel, lmt_wheel_entry_t *entry);
+
+/**
+  * @brief  Advance the wheel to now_ms, running the callback of every
+  *         entry that expires on the way, in tick order. Empty stretches
+  *         of the wheel are skipped.
+  * 
+  * @param[in,out] wheel : Timing wheel.
+  * @param[in] now_ms : Current tick, may wrap.
+  * 
+  * @return Number of entries expired
+  */
+uint32_t lmt_wheel_advance(lmt_wheel_t *wheel, uint32_t now_ms);
+
+/**
+  * @brief  Time until the wheel next has work, to sleep for. Never later
+  *         than the next expiry, but may be earlier, when a coarse slot
+  *         has to be cascaded.
+  * 
+  * @param[in] wheel : Timing wheel.
+  * 
+  * @return Delay (ms), UINT32_MAX if the wheel is empty
+  */
+uint32_t lmt_wheel_next(const lmt_wheel_t *wheel);
+
+/**
+  * @brief  Start reading a device periodically, the first reading
+  *         delay_ms from now.
+  * 
+  * @param[in,out] wheel : Timing wheel.
+  * @param[in,out] rdr : Reader, options filled in.
+  * @param[in] dev : LMT01 device structure.
+  * @param[in] delay_ms : Delay to the first reading (ms).
+  * 
+  * @return result of API execution status
+  * @retval lmt_status_t
+  */
+lmt_status_t lmt_wheel_reader_start(lmt_wheel_t *wheel, lmt_wheel_reader_t *rdr,
+                                    const lmt01_dev_t *dev, uint32_t delay_ms);
+
+/**
+  * @brief  Stop a reader. A reading in progress is abandoned.
+  * 
+  * @param[in,out] rdr : Reader.
+  */
+void lmt_wheel_reader_stop(lmt_wheel_reader_t *rdr);
+
+#ifdef __cplusplus
+}
+#endif /* End of CPP guard */
+#endif /* _LMT01_WHEEL_H_ */
@@ -0,0 +1,286 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        lmt01_rec.c
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file lmt01_rec.c
+ * @brief Recording HAL for the host simulator.
+ */
+#include "lmt01_rec.h"
+#include "lmt01_sim.h"
+#include <stddef.h>
+#include <string.h>
+
+/*
+ * @brief Recorder that delay_ms, which has no context, is logged on.
+ *        One per process, see lmt_rec_attach().
+ */
+static lmt_rec_t *rec_delay;
+
+/*!
+ * @brief This internal API logs one call.
+ *
+ * @param[in,out] rec : Recorder.
+ * @param[in] kind : lmt_rec_kind_t.
+ * @param[in] arg : Call argument.
+ */
+static void record(lmt_rec_t *rec, uint8_t kind, uint32_t arg);
+
+/*!
+ * @brief HAL calls seen by the driver, forwarded to the device behind.
+ */
+static void rec_start_timer(void *timer);
+static void rec_stop_timer(void *timer);
+static void rec_set_timer_cnt(void *timer, uint32_t *cnt);
+static void rec_get_timer_cnt(void *timer, uint32_t *cnt);
+static void rec_delay_ms(uint32_t ms);
+static void rec_arm_gap_timer(void *timer, uint32_t gap_ms);
+static uint8_t rec_gap_expired(void *timer);
+static uint32_t rec_time_us(void *timer);
+static void rec_set_power(void *timer, uint8_t on);
+static void rec_sleep_until(void *timer, uint32_t wake_us);
+
+void lmt_rec_attach(lmt_rec_t *rec, lmt01_dev_t *dev)
+{
+    rec->inner = *dev;
+    rec->ctx[0].rec = rec;
+    rec->ctx[0].timer = dev->timer;
+    rec->ctx[1].rec = rec;
+    rec->ctx[1].timer = dev->timer_b;
+    lmt_rec_clear(rec);
+
+    dev->timer = &rec->ctx[0];
+
+    if (dev->timer_b != NULL)
+        dev->timer_b = &rec->ctx[1];
+
+    /* Register access bypasses the HAL: take the HAL path so it is
+       recorded. Restored by lmt_rec_detach(). */
+    dev->cnt_reg = NULL;
+    dev->en_reg = NULL;
+
+    dev->start_timer = (dev->start_timer != NULL) ? rec_start_timer : NULL;
+    dev->stop_timer = (dev->stop_timer != NULL) ? rec_stop_timer : NULL;
+    dev->set_timer_cnt = (dev->set_timer_cnt != NULL) ? rec_set_timer_cnt : NULL;
+    dev->get_timer_cnt = (dev->get_timer_cnt != NULL) ? rec_get_timer_cnt : NULL;
+    dev->delay_ms = (dev->delay_ms != NULL) ? rec_delay_ms : NULL;
+    dev->arm_gap_timer = (dev->arm_gap_timer != NULL) ? rec_arm_gap_timer : NULL;
+    dev->gap_expired = (dev->gap_expired != NULL) ? rec_gap_expired : NULL;
+    dev->get_time_us = (dev->get_time_us != NULL) ? rec_time_us : NULL;
+    dev->set_power = (dev->set_power != NULL) ? rec_set_power : NULL;
+    dev->sleep_until = (dev->sleep_until != NULL) ? rec_sleep_until : NULL;
+
+    rec_delay = rec;
+}
+
+void lmt_rec_route_delay(lmt_rec_t *rec)
+{
+    rec_delay = rec;
+}
+
+void lmt_rec_detach(lmt_rec_t *rec, lmt01_dev_t *dev)
+{
+    *dev = rec->inner;
+
+    if (rec_delay == rec)
+        rec_delay = NULL;
+}
+
+void lmt_rec_clear(lmt_rec_t *rec)
+{
+    rec->len = 0;
+    rec->dropped = 0;
+    rec->waited_us = 0;
+    memset(rec->counts, 0, sizeof(rec->counts));
+}
+
+uint32_t lmt_rec_calls(const lmt_rec_t *rec)
+{
+    uint32_t calls = 0;
+    uint32_t i;
+
+    for (i = 0; i < LMT_REC_KINDS; i++)
+        calls += rec->counts[i];
+
+    return calls;
+}
+
+uint8_t lmt_rec_check(const lmt_rec_t *rec, const lmt_rec_budget_t *budget)
+{
+    uint32_t timer_ops = rec->counts[LMT_REC_START_TIMER] + rec->counts[LMT_REC_STOP_TIMER] +
+                         rec->counts[LMT_REC_SET_TIMER_CNT] + rec->counts[LMT_REC_GET_TIMER_CNT];
+    uint32_t waits = rec->counts[LMT_REC_DELAY_MS] + rec->counts[LMT_REC_SLEEP_UNTIL];
+    uint8_t over = 0;
+
+    if (budget->max_calls != 0 && lmt_rec_calls(rec) > budget->max_calls)
+        over |= LMT_REC_OVER_CALLS;
+
+    if (budget->max_timer_ops != 0 && timer_ops > budget->max_timer_ops)
+        over |= LMT_REC_OVER_TIMER_OPS;
+
+    if (budget->max_waits != 0 && waits > budget->max_waits)
+        over |= LMT_REC_OVER_WAITS;
+
+    if (budget->max_wait_ms != 0 && rec->waited_us > (uint64_t)budget->max_wait_ms * 1000)
+        over |= LMT_REC_OVER_WAIT_MS;
+
+    return over;
+}
+
+const char *lmt_rec_name(uint8_t kind)
+{
+    static const char *const names[LMT_REC_KINDS] = {
+        "start_timer", "stop_timer", "set_timer_cnt", "get_timer_cnt", "delay_ms",
+        "sleep_until", "get_time_us", "arm_gap_timer", "gap_expired", "set_power"
+    };
+
+    return (kind < LMT_REC_KINDS) ? names[kind] : "?";
+}
+
+static void rec_start_timer(void *timer)
+{
+    lmt_rec_ctx_t *ctx = timer;
+    lmt_rec_t *rec = ctx->rec;
+
+    record(rec, LMT_REC_START_TIMER, 0);
+    rec->inner.start_timer(ctx->timer);
+}
+
+static void rec_stop_timer(void *timer)
+{
+    lmt_rec_ctx_t *ctx = timer;
+    lmt_rec_t *rec = ctx->rec;
+
+    record(rec, LMT_REC_STOP_TIMER, 0);
+    rec->inner.stop_timer(ctx->timer);
+}
+
+static void rec_set_timer_cnt(void *timer, uint32_t *cnt)
+{
+    lmt_rec_ctx_t *ctx = timer;
+    lmt_rec_t *rec = ctx->rec;
+
+    record(rec, LMT_REC_SET_TIMER_CNT, *cnt);
+    rec->inner.set_timer_cnt(ctx->timer, cnt);
+}
+
+static void rec_get_timer_cnt(void *timer, uint32_t *cnt)
+{
+    lmt_rec_ctx_t *ctx = timer;
+    lmt_rec_t *rec = ctx->rec;
+
+    rec->inner.get_timer_cnt(ctx->timer, cnt);
+    record(rec, LMT_REC_GET_TIMER_CNT, *cnt);
+}
+
+static void rec_delay_ms(uint32_t ms)
+{
+    lmt_rec_t *rec = rec_delay;
+
+    if (rec == NULL)
+    {
+        lmt_sim_delay_ms(ms);
+        return;
+    }
+
+    record(rec, LMT_REC_DELAY_MS, ms);
+    rec->waited_us += (uint64_t)ms * 1000;
+    rec->inner.delay_ms(ms);
+}
+
+static void rec_arm_gap_timer(void *timer, uint32_t gap_ms)
+{
+    lmt_rec_ctx_t *ctx = timer;
+    lmt_rec_t *rec = ctx->rec;
+
+    record(rec, LMT_REC_ARM_GAP_TIMER, gap_ms);
+    rec->inner.arm_gap_timer(ctx->timer, gap_ms);
+}
+
+static uint8_t rec_gap_expired(void *timer)
+{
+    lmt_rec_ctx_t *ctx = timer;
+    lmt_rec_t *rec = ctx->rec;
+    uint8_t expired = rec->inner.gap_expired(ctx->timer);
+
+    record(rec, LMT_REC_GAP_EXPIRED, expired);
+
+    return expired;
+}
+
+static uint32_t rec_time_us(void *timer)
+{
+    lmt_rec_ctx_t *ctx = timer;
+    lmt_rec_t *rec = ctx->rec;
+    uint32_t now = rec->inner.get_time_us(ctx->timer);
+
+    record(rec, LMT_REC_TIME_US, now);
+
+    return now;
+}
+
+static void rec_set_power(void *timer, uint8_t on)
+{
+    lmt_rec_ctx_t *ctx = timer;
+    lmt_rec_t *rec = ctx->rec;
+
+    record(rec, LMT_REC_SET_POWER, on);
+    rec->inner.set_power(ctx->timer, on);
+}
+
+static void rec_sleep_until(void *timer, uint32_t wake_us)
+{
+    lmt_rec_ctx_t *ctx = timer;
+    lmt_rec_t *rec = ctx->rec;
+    uint64_t before = lmt_sim_now_us();
+
+    record(rec, LMT_REC_SLEEP_UNTIL, wake_us - (uint32_t)before);
+    rec->inner.sleep_until(ctx->timer, wake_us);
+    rec->waited_us += lmt_sim_now_us() - before;
+}
+
+/*!
+ * @brief This internal API logs one call.
+ */
+static void record(lmt_rec_t *rec, uint8_t kind, uint32_t arg)
+{
+    rec->counts[kind]++;
+
+    if (rec->log == NULL)
+        return;
+
+    if (rec->len == rec->cap)
+    {
+        rec->dropped++;
+        return;
+    }
+
+    rec->log[rec->len].t_us = lmt_sim_now_us();
+    rec->log[rec->len].kind = kind;
+    rec->log[rec->len].arg = arg;
+    rec->len++;
+}
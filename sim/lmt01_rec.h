@@ -0,0 +1,205 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        lmt01_rec.h
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file lmt01_rec.h
+ * @brief Recording HAL for the host simulator. Sits between the driver
+ *        and a simulated device and logs every HAL call with its virtual
+ *        time, so the cost of a reading can be counted and held to a
+ *        budget.
+ */
+
+#ifndef _LMT01_REC_H_
+#define _LMT01_REC_H_
+
+/*! CPP guard */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "lmt01.h"
+
+/*!
+ * @brief  HAL calls recorded
+ */
+typedef enum {
+    LMT_REC_START_TIMER,
+    LMT_REC_STOP_TIMER,
+    LMT_REC_SET_TIMER_CNT,
+    LMT_REC_GET_TIMER_CNT,
+    LMT_REC_DELAY_MS,
+    LMT_REC_SLEEP_UNTIL,
+    LMT_REC_TIME_US,
+    LMT_REC_ARM_GAP_TIMER,
+    LMT_REC_GAP_EXPIRED,
+    LMT_REC_SET_POWER,
+    LMT_REC_KINDS
+} lmt_rec_kind_t;
+
+/*!
+ * @brief  Budget check results, one bit per exceeded limit
+ */
+#define LMT_REC_OVER_CALLS      (1 << 0)
+#define LMT_REC_OVER_TIMER_OPS  (1 << 1)
+#define LMT_REC_OVER_WAITS      (1 << 2)
+#define LMT_REC_OVER_WAIT_MS    (1 << 3)
+
+/*!
+ * @brief  One logged HAL call
+ */
+typedef struct
+{
+    /* Virtual time of the call (us) */
+    uint64_t t_us;
+
+    /* lmt_rec_kind_t */
+    uint8_t kind;
+
+    /* Argument: count set or read, ms or us waited, gap, power state */
+    uint32_t arg;
+
+} lmt_rec_event_t;
+
+/*!
+ * @brief  Timer context handed to the driver: the recorder and the
+ *         simulated timer behind it
+ */
+typedef struct
+{
+    void *rec;
+    void *timer;
+
+} lmt_rec_ctx_t;
+
+/*!
+ * @brief  Recorder. Attach it to a simulated device; the device then
+ *         calls the recorder, which logs and forwards to the simulator.
+ */
+typedef struct
+{
+    /* Option: log buffer, may be NULL to only count */
+    lmt_rec_event_t *log;
+    uint32_t cap;
+
+    /* Events logged, and events that did not fit */
+    uint32_t len;
+    uint32_t dropped;
+
+    /* Calls by kind */
+    uint32_t counts[LMT_REC_KINDS];
+
+    /* Time waited in delay_ms and sleep_until (us) */
+    uint64_t waited_us;
+
+    /* Device as it was before attaching, called through */
+    lmt01_dev_t inner;
+
+    /* Contexts for timer and timer_b */
+    lmt_rec_ctx_t ctx[2];
+
+} lmt_rec_t;
+
+/*!
+ * @brief  Per-reading limits. 0 leaves a limit unchecked.
+ */
+typedef struct
+{
+    /* All HAL calls */
+    uint32_t max_calls;
+
+    /* start/stop/set/get timer calls */
+    uint32_t max_timer_ops;
+
+    /* delay_ms and sleep_until calls */
+    uint32_t max_waits;
+
+    /* Time waited (ms) */
+    uint32_t max_wait_ms;
+
+} lmt_rec_budget_t;
+
+/**
+  * @brief  Put a recorder between the driver and dev. Every HAL pointer
+  *         dev has is routed through the recorder.
+  * 
+  *         delay_ms has no context, so there is one delay recorder per
+  *         process: the one attached last, or chosen by
+  *         lmt_rec_route_delay(). With several devices attached, their
+  *         delays all land there. Sum the recorders of a group, or route
+  *         the delays to the device under test.
+  * 
+  *         cnt_reg and en_reg are cleared so the driver takes the HAL
+  *         timer path, which is what gets recorded. A device that uses
+  *         the register path makes fewer timer calls than counted here.
+  * 
+  * @param[in,out] rec : Recorder, log and cap filled in.
+  * @param[in,out] dev : Device, already wired to the simulator.
+  */
+void lmt_rec_attach(lmt_rec_t *rec, lmt01_dev_t *dev);
+
+/**
+  * @brief  Log delay_ms calls, from any attached device, on rec.
+  */
+void lmt_rec_route_delay(lmt_rec_t *rec);
+
+/**
+  * @brief  Restore dev as it was before lmt_rec_attach(), registers
+  *         included.
+  */
+void lmt_rec_detach(lmt_rec_t *rec, lmt01_dev_t *dev);
+
+/**
+  * @brief  Clear the log and counts.
+  */
+void lmt_rec_clear(lmt_rec_t *rec);
+
+/**
+  * @brief  All HAL calls recorded.
+  */
+uint32_t lmt_rec_calls(const lmt_rec_t *rec);
+
+/**
+  * @brief  Check the calls recorded since the last clear against a budget.
+  * 
+  * @param[in] rec : Recorder.
+  * @param[in] budget : Limits.
+  * 
+  * @return 0 within budget, else LMT_REC_OVER_* bits
+  */
+uint8_t lmt_rec_check(const lmt_rec_t *rec, const lmt_rec_budget_t *budget);
+
+/**
+  * @brief  Name of a call kind, for reports.
+  */
+const char *lmt_rec_name(uint8_t kind);
+
+#ifdef __cplusplus
+}
+#endif /* End of CPP guard */
+#endif /* _LMT01_REC_H_ */
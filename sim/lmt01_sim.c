@@ -0,0 +1,335 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        lmt01_sim.c
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file lmt01_sim.c
+ * @brief Host simulator for the LMT01 and the timer peripherals the driver uses.
+ */
+#include "lmt01_sim.h"
+#include <stddef.h>
+#include <string.h>
+
+/*
+ * @brief Virtual clock shared by every simulated peripheral (us)
+ */
+static uint64_t sim_now_us;
+
+/*
+ * @brief Power accounting
+ */
+static lmt_sim_power_t sim_power = {
+    LMT_SIM_RUN_UA, LMT_SIM_SLEEP_UA, LMT_SIM_SENSOR_UA, LMT_SIM_SUPPLY_MV, LMT_SIM_HAL_US,
+    0, 0, 0, 0, 0
+};
+
+/*!
+ * @brief This internal API returns the time of pulse n (0-based) of the
+ * burst in the given output cycle.
+ */
+static uint64_t pulse_time(const lmt_sim_sensor_t *s, uint64_t cycle, uint32_t n);
+
+/*!
+ * @brief This internal API returns the current count of a simulated counter.
+ */
+static uint32_t timer_count(const lmt_sim_timer_t *t);
+
+/*!
+ * @brief This internal API returns when the armed gap timer of a counter
+ * expires, UINT64_MAX if it never does.
+ */
+static uint64_t gap_expiry(const lmt_sim_timer_t *t);
+
+/*!
+ * @brief This internal API charges the awake time of one HAL call, on
+ * the virtual clock and in the power model.
+ */
+static void hal_call(void);
+
+
+void lmt_sim_sensor_init(lmt_sim_sensor_t *sensor, float temp)
+{
+    sensor->pulses = lmt_temperature_to_pulses(temp);
+    sensor->phase_us = 0;
+    sensor->period_us = LMT_SIM_PERIOD_US;
+    sensor->conv_us = LMT_SIM_CONV_US;
+    sensor->freq_hz = LMT_SIM_FREQ_HZ;
+    sensor->off_us = 0;
+    sensor->off_at_us = 0;
+}
+
+void lmt_sim_dev_init(lmt01_dev_t *dev, lmt_sim_timer_t *timer, lmt_sim_sensor_t *sensor)
+{
+    memset(dev, 0, sizeof(*dev));
+    memset(timer, 0, sizeof(*timer));
+
+    timer->sensor = sensor;
+
+    dev->timer = timer;
+    dev->start_timer = lmt_sim_start_timer;
+    dev->stop_timer = lmt_sim_stop_timer;
+    dev->set_timer_cnt = lmt_sim_set_timer_cnt;
+    dev->get_timer_cnt = lmt_sim_get_timer_cnt;
+    dev->delay_ms = lmt_sim_delay_ms;
+    dev->get_time_us = lmt_sim_time_us;
+    dev->set_power = lmt_sim_set_power;
+    dev->sleep_until = lmt_sim_sleep_until;
+}
+
+uint64_t lmt_sim_now_us(void)
+{
+    return sim_now_us;
+}
+
+void lmt_sim_advance_us(uint64_t us)
+{
+    sim_now_us += us;
+}
+
+void lmt_sim_reset(void)
+{
+    lmt_sim_power_t defaults = {
+        LMT_SIM_RUN_UA, LMT_SIM_SLEEP_UA, LMT_SIM_SENSOR_UA, LMT_SIM_SUPPLY_MV, LMT_SIM_HAL_US,
+        0, 0, 0, 0, 0
+    };
+
+    sim_now_us = 0;
+    sim_power = defaults;
+}
+
+lmt_sim_power_t *lmt_sim_power(void)
+{
+    return &sim_power;
+}
+
+uint64_t lmt_sim_sensor_on_us(const lmt_sim_sensor_t *sensor)
+{
+    uint64_t off = sensor->off_us;
+
+    if (sensor->phase_us == UINT64_MAX)
+        off += sim_now_us - sensor->off_at_us;
+
+    return sim_now_us - off;
+}
+
+double lmt_sim_energy_uj(const lmt_sim_power_t *pw, uint64_t elapsed_us, uint64_t sensor_on_us)
+{
+    uint64_t awake = (pw->awake_us < elapsed_us) ? pw->awake_us : elapsed_us;
+
+    /* uA * us * mV = 1e-15 J */
+    return ((double)awake * pw->run_ua +
+            (double)(elapsed_us - awake) * pw->sleep_ua +
+            (double)sensor_on_us * pw->sensor_ua) * pw->supply_mv * 1e-9;
+}
+
+uint64_t lmt_sim_pulses_before(const lmt_sim_sensor_t *s, uint64_t t_us)
+{
+    if (s == NULL || t_us <= s->phase_us)
+        return 0;
+
+    uint64_t t = t_us - s->phase_us;
+    uint64_t cycles = t / s->period_us;
+    uint64_t r = t % s->period_us;
+    uint64_t pulses = cycles * s->pulses;
+
+    /* Pulse n of a burst is emitted at conv_us + n / freq_hz */
+    if (r > s->conv_us)
+    {
+        uint64_t n = ((r - s->conv_us) * s->freq_hz + 999999) / 1000000;
+        pulses += (n < s->pulses) ? n : s->pulses;
+    }
+
+    return pulses;
+}
+
+void lmt_sim_start_timer(void *timer)
+{
+    lmt_sim_timer_t *t = timer;
+
+    hal_call();
+
+    if (!t->running)
+    {
+        t->running = 1;
+        t->since_us = sim_now_us;
+    }
+}
+
+void lmt_sim_stop_timer(void *timer)
+{
+    lmt_sim_timer_t *t = timer;
+
+    hal_call();
+
+    if (t->running)
+    {
+        t->base = timer_count(t);
+        t->running = 0;
+    }
+}
+
+void lmt_sim_set_timer_cnt(void *timer, uint32_t *cnt)
+{
+    lmt_sim_timer_t *t = timer;
+
+    hal_call();
+
+    t->base = *cnt;
+    t->since_us = sim_now_us;
+}
+
+void lmt_sim_get_timer_cnt(void *timer, uint32_t *cnt)
+{
+    hal_call();
+
+    *cnt = timer_count(timer);
+}
+
+void lmt_sim_delay_ms(uint32_t ms)
+{
+    sim_now_us += (uint64_t)ms * 1000;
+    sim_power.awake_us += (uint64_t)ms * 1000;
+    sim_power.delays++;
+}
+
+void lmt_sim_sleep_until(void *timer, uint32_t wake_us)
+{
+    int32_t left = (int32_t)(wake_us - (uint32_t)sim_now_us);
+    uint64_t expiry = (timer != NULL) ? gap_expiry(timer) : UINT64_MAX;
+
+    /* The gap timer interrupt wakes the MCU early */
+    if (left > 0 && expiry > sim_now_us && expiry < sim_now_us + (uint64_t)left)
+        left = (int32_t)(expiry - sim_now_us);
+
+    if (left > 0)
+    {
+        sim_now_us += (uint64_t)left;
+        sim_power.sleep_us += (uint64_t)left;
+    }
+
+    sim_power.sleeps++;
+}
+
+void lmt_sim_arm_gap_timer(void *timer, uint32_t gap_ms)
+{
+    lmt_sim_timer_t *t = timer;
+
+    hal_call();
+
+    t->gap_armed = 1;
+    t->gap_armed_us = sim_now_us;
+    t->gap_us = gap_ms * 1000;
+}
+
+uint8_t lmt_sim_gap_expired(void *timer)
+{
+    hal_call();
+
+    return sim_now_us >= gap_expiry(timer);
+}
+
+/*!
+ * @brief This internal API returns when the armed gap timer expires.
+ */
+static uint64_t gap_expiry(const lmt_sim_timer_t *t)
+{
+    const lmt_sim_sensor_t *s = t->sensor;
+
+    if (!t->gap_armed || s == NULL || s->pulses == 0 || sim_now_us <= s->phase_us)
+        return UINT64_MAX;
+
+    /* The one-shot is triggered by the first edge after arming, which is
+       the pulse following those already emitted... */
+    uint64_t cycle = lmt_sim_pulses_before(s, t->gap_armed_us) / s->pulses;
+
+    /* ... and retriggered by every edge until the end of that burst */
+    return pulse_time(s, cycle, s->pulses - 1) + t->gap_us;
+}
+
+/*!
+ * @brief This internal API returns the time of a pulse.
+ */
+static uint64_t pulse_time(const lmt_sim_sensor_t *s, uint64_t cycle, uint32_t n)
+{
+    return s->phase_us + cycle * s->period_us + s->conv_us +
+           ((uint64_t)n * 1000000) / s->freq_hz;
+}
+
+/*!
+ * @brief This internal API returns the current count of a simulated counter.
+ */
+static uint32_t timer_count(const lmt_sim_timer_t *t)
+{
+    if (!t->running)
+        return t->base;
+
+    return t->base + (uint32_t)(lmt_sim_pulses_before(t->sensor, sim_now_us) -
+                                lmt_sim_pulses_before(t->sensor, t->since_us));
+}
+
+uint32_t lmt_sim_time_us(void *timer)
+{
+    hal_call();
+
+    (void)timer;
+
+    return (uint32_t)sim_now_us;
+}
+
+void lmt_sim_set_power(void *timer, uint8_t on)
+{
+    lmt_sim_timer_t *t = timer;
+
+    hal_call();
+
+    /* Bank what has been counted, the sensor restarts from scratch */
+    if (t->running)
+    {
+        t->base = timer_count(t);
+        t->since_us = sim_now_us;
+    }
+
+    /* Off: no output until powered again */
+    if (on && t->sensor->phase_us == UINT64_MAX)
+        t->sensor->off_us += sim_now_us - t->sensor->off_at_us;
+    else if (!on && t->sensor->phase_us != UINT64_MAX)
+        t->sensor->off_at_us = sim_now_us;
+
+    t->sensor->phase_us = on ? sim_now_us : UINT64_MAX;
+}
+
+/*!
+ * @brief This internal API charges the awake time of one HAL call. The
+ * call takes that long on the virtual clock too, as it would on a board,
+ * so get_time_us sees it.
+ */
+static void hal_call(void)
+{
+    sim_now_us += sim_power.hal_us;
+    sim_power.awake_us += sim_power.hal_us;
+    sim_power.hal_calls++;
+}
@@ -0,0 +1,209 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        lmt01_sim.h
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file lmt01_sim.h
+ * @brief Host simulator for the LMT01 and the timer peripherals the driver
+ *        uses. Time is virtual: delay_ms advances a shared clock instantly.
+ */
+
+#ifndef _LMT01_SIM_H_
+#define _LMT01_SIM_H_
+
+/*! CPP guard */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "lmt01.h"
+
+/*!
+ * @brief  Simulated sensor timing defaults (us, Hz)
+ */
+#define LMT_SIM_PERIOD_US   104000
+#define LMT_SIM_CONV_US     54000
+#define LMT_SIM_FREQ_HZ     88000
+
+/*!
+ * @brief  Power model defaults: MCU run and sleep current, sensor current
+ *         while powered (uA), supply (mV), and the awake time charged for
+ *         each HAL call (us)
+ */
+#define LMT_SIM_RUN_UA      3000
+#define LMT_SIM_SLEEP_UA    3
+#define LMT_SIM_SENSOR_UA   34
+#define LMT_SIM_SUPPLY_MV   3300
+#define LMT_SIM_HAL_US      1
+
+/*!
+ * @brief  Simulated LMT01. Converts for conv_us, then emits pulses at
+ *         freq_hz, repeating every period_us from power-up at phase_us.
+ */
+typedef struct
+{
+    /* Pulses per burst */
+    uint32_t pulses;
+
+    /* Time of power-up (us) */
+    uint64_t phase_us;
+
+    /* Output period (us) */
+    uint32_t period_us;
+
+    /* Conversion time before each burst (us) */
+    uint32_t conv_us;
+
+    /* Pulse frequency (Hz) */
+    uint32_t freq_hz;
+
+    /* Time spent unpowered (us), and when it was last switched off */
+    uint64_t off_us;
+    uint64_t off_at_us;
+
+} lmt_sim_sensor_t;
+
+/*!
+ * @brief  Power accounting. The MCU is awake in delay_ms and for
+ *         hal_us per HAL call, and asleep the rest of the time:
+ *         in sleep_until, or between readings. A HAL call also advances
+ *         the virtual clock by hal_us.
+ */
+typedef struct
+{
+    /* Option: figures used for energy, see LMT_SIM_* defaults */
+    uint32_t run_ua;
+    uint32_t sleep_ua;
+    uint32_t sensor_ua;
+    uint32_t supply_mv;
+    uint32_t hal_us;
+
+    /* Time awake (us) */
+    uint64_t awake_us;
+
+    /* Time in sleep_until (us) */
+    uint64_t sleep_us;
+
+    /* HAL calls, delay_ms and sleep_until calls */
+    uint32_t hal_calls;
+    uint32_t delays;
+    uint32_t sleeps;
+
+} lmt_sim_power_t;
+
+/*!
+ * @brief  Simulated counter peripheral with a retriggerable gap timer.
+ */
+typedef struct
+{
+    /* Sensor connected to the counter input, and powered through it */
+    lmt_sim_sensor_t *sensor;
+
+    /* Counter state */
+    uint8_t running;
+    uint64_t since_us;
+    uint32_t base;
+
+    /* Gap timer state */
+    uint8_t gap_armed;
+    uint64_t gap_armed_us;
+    uint32_t gap_us;
+
+} lmt_sim_timer_t;
+
+/**
+  * @brief  Fill in a sensor with datasheet timing and the pulse count
+  *         for the given temperature.
+  * 
+  * @param[out] sensor : Simulated sensor.
+  * @param[in] temp : Temperature (*C).
+  */
+void lmt_sim_sensor_init(lmt_sim_sensor_t *sensor, float temp);
+
+/**
+  * @brief  Wire a device structure to a simulated counter and sensor.
+  * 
+  * @param[out] dev : LMT01 device structure.
+  * @param[out] timer : Simulated counter.
+  * @param[in] sensor : Simulated sensor.
+  */
+void lmt_sim_dev_init(lmt01_dev_t *dev, lmt_sim_timer_t *timer, lmt_sim_sensor_t *sensor);
+
+/**
+  * @brief  Virtual clock.
+  */
+uint64_t lmt_sim_now_us(void);
+void lmt_sim_advance_us(uint64_t us);
+void lmt_sim_reset(void);
+
+/**
+  * @brief  Power accounting of the simulation, cleared by lmt_sim_reset()
+  *         with the figures set back to defaults.
+  */
+lmt_sim_power_t *lmt_sim_power(void);
+
+/**
+  * @brief  Time a sensor has been powered since the clock was reset (us).
+  */
+uint64_t lmt_sim_sensor_on_us(const lmt_sim_sensor_t *sensor);
+
+/**
+  * @brief  Energy used (uJ): MCU awake and asleep over elapsed_us, plus
+  *         sensors powered for sensor_on_us in total.
+  * 
+  * @param[in] pw : Power accounting.
+  * @param[in] elapsed_us : Time the MCU ran for.
+  * @param[in] sensor_on_us : Sum of sensor powered time.
+  */
+double lmt_sim_energy_uj(const lmt_sim_power_t *pw, uint64_t elapsed_us, uint64_t sensor_on_us);
+
+/**
+  * @brief  Pulses emitted by sensor in [0, t).
+  */
+uint64_t lmt_sim_pulses_before(const lmt_sim_sensor_t *sensor, uint64_t t_us);
+
+/**
+  * @brief  HAL functions, usable directly as lmt01_dev_t function pointers.
+  *         lmt_sim_sleep_until returns early when the counter's armed gap
+  *         timer expires, as its interrupt would wake the MCU.
+  */
+void lmt_sim_start_timer(void *timer);
+void lmt_sim_stop_timer(void *timer);
+void lmt_sim_set_timer_cnt(void *timer, uint32_t *cnt);
+void lmt_sim_get_timer_cnt(void *timer, uint32_t *cnt);
+void lmt_sim_delay_ms(uint32_t ms);
+void lmt_sim_arm_gap_timer(void *timer, uint32_t gap_ms);
+uint8_t lmt_sim_gap_expired(void *timer);
+uint32_t lmt_sim_time_us(void *timer);
+void lmt_sim_set_power(void *timer, uint8_t on);
+void lmt_sim_sleep_until(void *timer, uint32_t wake_us);
+
+#ifdef __cplusplus
+}
+#endif /* End of CPP guard */
+#endif /* _LMT01_SIM_H_ */
@@ -0,0 +1,197 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * 
+ * File        coalesce_test.c
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file coalesce_test.c
+ * @brief Wakeup coalescing planner tests: grouping, the slack limit,
+ *        divisors and due ticks.
+ */
+#include <stdio.h>
+
+#include "lmt01_coalesce.h"
+
+#define CHECK(cond)                                                     \
+    do                                                                  \
+    {                                                                   \
+        if (!(cond))                                                    \
+        {                                                               \
+            printf("    %s:%d: %s\n", __FILE__, __LINE__, #cond);       \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+typedef uint32_t (*test_fptr_t)(void);
+
+/* Plan n periods */
+static lmt_status_t plan_of(lmt_coalesce_t *plan, const uint32_t *periods, uint32_t n,
+                            uint32_t slack_ms, uint32_t *groups)
+{
+    uint32_t i;
+
+    for (i = 0; i < n; i++)
+        plan[i].period_ms = periods[i];
+
+    return lmt_coalesce_plan(plan, n, slack_ms, groups);
+}
+
+/* Near multiples of the shortest period share its tick */
+static uint32_t test_grouping(void)
+{
+    static const uint32_t periods[] = { 1000, 2000, 3000, 990 };
+    uint32_t failures = 0;
+    lmt_coalesce_t plan[4];
+    uint32_t groups = 0, i;
+
+    CHECK(plan_of(plan, periods, 4, 50, &groups) == LMT_OK);
+    CHECK(groups == 1);
+
+    for (i = 0; i < 4; i++)
+    {
+        CHECK(plan[i].group == 0);
+        CHECK(plan[i].tick_ms == 990);
+    }
+
+    CHECK(plan[0].divisor == 1);
+    CHECK(plan[1].divisor == 2);
+    CHECK(plan[2].divisor == 3);
+    CHECK(plan[3].divisor == 1);
+
+    /* No slack: every period alone but exact multiples */
+    CHECK(plan_of(plan, periods, 4, 0, &groups) == LMT_OK);
+    CHECK(groups == 2);
+    CHECK(plan[0].group == plan[1].group && plan[1].group == plan[2].group);
+    CHECK(plan[0].group != plan[3].group);
+    CHECK(plan[2].tick_ms == 1000 && plan[2].divisor == 3);
+
+    return failures;
+}
+
+/* A period joins a group only within the slack, the limit included */
+static uint32_t test_slack_edge(void)
+{
+    static const uint32_t periods[] = { 1000, 1050 };
+    uint32_t failures = 0;
+    lmt_coalesce_t plan[2];
+    uint32_t groups = 0;
+
+    CHECK(plan_of(plan, periods, 2, 50, &groups) == LMT_OK);
+    CHECK(groups == 1);
+    CHECK(plan[1].tick_ms == 1000 && plan[1].divisor == 1);
+
+    CHECK(plan_of(plan, periods, 2, 49, &groups) == LMT_OK);
+    CHECK(groups == 2);
+    CHECK(plan[1].tick_ms == 1050 && plan[1].divisor == 1);
+
+    return failures;
+}
+
+/* The divisor is the nearest multiple, and the longest tick wins */
+static uint32_t test_divisor(void)
+{
+    static const uint32_t rounding[] = { 1000, 2600, 2400 };
+    static const uint32_t longest[] = { 300, 700, 2100 };
+    uint32_t failures = 0;
+    lmt_coalesce_t plan[3];
+    uint32_t groups = 0;
+
+    CHECK(plan_of(plan, rounding, 3, 400, &groups) == LMT_OK);
+    CHECK(groups == 1);
+    CHECK(plan[1].divisor == 3);
+    CHECK(plan[2].divisor == 2);
+
+    /* 2100 is 7 ticks of 300 and 3 of 700: it takes the 700 group */
+    CHECK(plan_of(plan, longest, 3, 0, &groups) == LMT_OK);
+    CHECK(groups == 2);
+    CHECK(plan[2].group == plan[1].group);
+    CHECK(plan[2].tick_ms == 700 && plan[2].divisor == 3);
+
+    return failures;
+}
+
+/* Due every divisor ticks from tick 0, and the wakeups that follow */
+static uint32_t test_due(void)
+{
+    static const uint32_t periods[] = { 1000, 2000 };
+    uint32_t failures = 0;
+    lmt_coalesce_t plan[2];
+    lmt_coalesce_t three = { 0, 0, 100, 3 };
+    uint32_t tick, due = 0;
+
+    for (tick = 0; tick < 9; tick++)
+        due |= (uint32_t)lmt_coalesce_due(&three, tick) << tick;
+
+    CHECK(due == ((1u << 0) | (1u << 3) | (1u << 6)));
+
+    CHECK(plan_of(plan, periods, 2, 0, NULL) == LMT_OK);
+    CHECK(lmt_coalesce_wakeups_per_hour(plan, 2, 1) == 3600);
+    CHECK(lmt_coalesce_wakeups_per_hour(plan, 2, 0) == 3600 + 1800);
+
+    return failures;
+}
+
+/* Bad input */
+static uint32_t test_invalid(void)
+{
+    static const uint32_t periods[] = { 1000, 0 };
+    uint32_t failures = 0;
+    lmt_coalesce_t plan[2];
+
+    CHECK(lmt_coalesce_plan(NULL, 1, 0, NULL) == LMT_E_NULL_PTR);
+    CHECK(plan_of(plan, periods, 2, 0, NULL) == LMT_E_INVALID);
+
+    return failures;
+}
+
+static const struct
+{
+    const char *name;
+    test_fptr_t fn;
+} tests[] = {
+    { "grouping",                  test_grouping },
+    { "slack_edge",                test_slack_edge },
+    { "divisor",                   test_divisor },
+    { "due",                       test_due },
+    { "invalid",                   test_invalid },
+};
+
+int main(void)
+{
+    uint32_t i, failed = 0, n;
+
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+    {
+        n = tests[i].fn();
+        printf("%-28s %s\n", tests[i].name, n ? "FAILED" : "ok");
+
+        if (n != 0)
+            failed++;
+    }
+
+    return (failed != 0) ? 1 : 0;
+}
@@ -0,0 +1,141 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        coro_test.cpp
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file coro_test.cpp
+ * @brief lmt01_coro.hpp on the simulator: many sensors read concurrently
+ *        by coroutines on one executor running on virtual time, with and
+ *        without reading options.
+ */
+#include <cstdio>
+
+#include "lmt01_coro.hpp"
+#include "lmt01_sim.h"
+
+#define SENSORS     200
+
+static lmt_sim_sensor_t sensors[SENSORS];
+static lmt_sim_timer_t timers[SENSORS];
+static lmt01_dev_t devs[SENSORS];
+static lmt::reading results[SENSORS];
+static uint32_t finished;
+
+static uint32_t alarms[SENSORS];
+
+static void on_alarm(void *ctx, uint32_t pulses)
+{
+    (void)pulses;
+    (*static_cast<uint32_t *>(ctx))++;
+}
+
+static lmt::task sample(lmt::executor &ex, uint32_t i)
+{
+    results[i] = co_await lmt::read(&devs[i], ex);
+    finished++;
+}
+
+/* With options: an alarm at half the count on even sensors, above it on odd */
+static lmt::task sample_alarm(lmt::executor &ex, uint32_t i)
+{
+    lmt_read_t opts = {};
+
+    opts.poll_ms = 2;
+    opts.alarm_pulses = (i & 1) ? sensors[i].pulses + 1 : sensors[i].pulses / 2;
+    opts.alarm_cb = on_alarm;
+    opts.alarm_ctx = &alarms[i];
+
+    results[i] = co_await lmt::read(&devs[i], opts, ex);
+    finished++;
+}
+
+int main()
+{
+    uint32_t i, failures = 0;
+    lmt::executor ex([] { return lmt_sim_now_us(); },
+                     [](uint64_t t_us) { lmt_sim_advance_us(t_us - lmt_sim_now_us()); });
+
+    lmt_sim_reset();
+
+    for (i = 0; i < SENSORS; i++)
+    {
+        lmt_sim_sensor_init(&sensors[i], -40.0f + (float)i);
+        sensors[i].phase_us = (uint64_t)i * 517;
+        lmt_sim_dev_init(&devs[i], &timers[i], &sensors[i]);
+    }
+
+    lmt_sim_advance_us(LMT_SIM_PERIOD_US * 2);
+
+    for (i = 0; i < SENSORS; i++)
+        sample(ex, i);
+
+    ex.run();
+
+    for (i = 0; i < SENSORS; i++)
+    {
+        if (results[i].rslt != LMT_OK || results[i].pulses != sensors[i].pulses)
+        {
+            std::printf("    sensor %u: status %d, %u pulses, expected %u\n", i,
+                        (int)results[i].rslt, results[i].pulses, sensors[i].pulses);
+            failures++;
+        }
+    }
+
+    /* All in flight together: about one reading's time, not SENSORS of them */
+    std::printf("%u of %u readings in %.1f ms virtual time\n", SENSORS - failures, SENSORS,
+                (lmt_sim_now_us() - LMT_SIM_PERIOD_US * 2) / 1000.0);
+
+    if (finished != SENSORS || lmt_sim_now_us() - LMT_SIM_PERIOD_US * 2 > 3 * LMT_SIM_PERIOD_US)
+        failures++;
+
+    /* Options reach the reading. Polling 200 sensors every 2 ms costs
+       enough HAL time to stretch the capture windows past a cycle, so
+       HAL calls are free here. */
+    finished = 0;
+    lmt_sim_power()->hal_us = 0;
+
+    for (i = 0; i < SENSORS; i++)
+        sample_alarm(ex, i);
+
+    ex.run();
+
+    for (i = 0; i < SENSORS; i++)
+    {
+        if (results[i].rslt != LMT_OK || results[i].pulses != sensors[i].pulses ||
+            alarms[i] != ((i & 1) ? 0u : 1u))
+        {
+            std::printf("    sensor %u: status %d, %u pulses, %u alarms\n", i,
+                        (int)results[i].rslt, results[i].pulses, alarms[i]);
+            failures++;
+        }
+    }
+
+    if (finished != SENSORS)
+        failures++;
+
+    return (failures != 0) ? 1 : 0;
+}
@@ -0,0 +1,308 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        hal_budget_test.c
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file hal_budget_test.c
+ * @brief HAL cost of each public API per reading, through the recording
+ *        HAL, held against a budget. Readings are taken at many sensor
+ *        phases and the worst case is reported. Exits non-zero if any
+ *        API fails or goes over its budget.
+ */
+#include <stdio.h>
+
+#include "lmt01.h"
+#include "lmt01_rec.h"
+#include "lmt01_sim.h"
+
+#define PHASES      26
+#define PHASE_US    4000
+
+/* Budget over the measured worst case, in percent, rounded up */
+#define HEADROOM_PCT    10
+
+static lmt_sim_sensor_t sensors[2];
+static lmt_sim_timer_t timers[3];
+static lmt01_dev_t devs[2];
+static lmt_rec_t recs[2];
+static const lmt01_dev_t *group[2] = { &devs[0], &devs[1] };
+
+static lmt_stream_t stream;
+static lmt_periodic_t periodic;
+static lmt_sync_t sync;
+
+/* Waits a non-blocking caller did between steps */
+static uint32_t caller_waits;
+static uint64_t caller_waited_us;
+
+typedef lmt_status_t (*case_fptr_t)(void);
+
+static lmt_status_t do_init(void)
+{
+    return lmt_init(&devs[0]);
+}
+
+static lmt_status_t do_probe(void)
+{
+    return lmt_probe(&devs[0]);
+}
+
+static lmt_status_t do_pulse_count(void)
+{
+    uint32_t pulses;
+
+    return lmt_get_pulse_count(&devs[0], &pulses);
+}
+
+static lmt_status_t do_temperature(void)
+{
+    float temp;
+
+    return lmt_get_temperature(&devs[0], &temp, CONV_TYPE_LUT);
+}
+
+static lmt_status_t do_nonblocking(void)
+{
+    lmt_read_t rd = {0};
+    lmt_status_t rslt = lmt_read_start(&devs[0], &rd);
+
+    while (rslt == LMT_BUSY)
+    {
+        caller_waits++;
+        caller_waited_us += (uint64_t)rd.wait_ms * 1000;
+        lmt_sim_advance_us((uint64_t)rd.wait_ms * 1000);
+        rslt = lmt_read_step(&rd);
+    }
+
+    return rslt;
+}
+
+static lmt_status_t do_multi(void)
+{
+    uint32_t pulses[2];
+    lmt_status_t rslts[2];
+
+    return lmt_get_pulse_count_multi(group, 2, pulses, rslts);
+}
+
+static lmt_status_t do_sync(void)
+{
+    uint32_t pulses[2];
+    lmt_status_t rslts[2];
+
+    return lmt_sync_read(group, 2, &sync, pulses, rslts);
+}
+
+static lmt_status_t do_stream(void)
+{
+    uint32_t pulses;
+
+    return lmt_stream_next(&devs[0], &stream, &pulses);
+}
+
+static lmt_status_t do_periodic(void)
+{
+    uint32_t pulses;
+
+    return lmt_periodic_next(&devs[0], &periodic, &pulses);
+}
+
+static lmt_status_t do_characterise(void)
+{
+    return lmt_characterise(&devs[0], NULL);
+}
+
+static lmt_status_t do_power_cycle(void)
+{
+    return lmt_power_cycle(group, 2);
+}
+
+typedef struct
+{
+    const char *name;
+    case_fptr_t fn;
+    uint8_t gap_timer;
+    uint8_t boot;
+    uint8_t group;
+    lmt_rec_budget_t measured;
+} case_t;
+
+/* Worst case measured per call: HAL calls, timer ops, waits, waited ms.
+   The budget is HEADROOM_PCT over these. init and probe run as at boot,
+   just after the sensor is powered. Group cases count both devices;
+   the others only the first, which must be the only one called. For
+   lmt_read_start/step the waits are the caller's, between steps.
+   Re-measure and update these when the driver changes. */
+static const case_t cases[] = {
+    { "lmt_init",                   do_init,         0, 1, 0, { 167,  59,  54,  54 } },
+    { "lmt_probe",                  do_probe,        0, 1, 0, { 167,  59,  54,  54 } },
+    { "lmt_get_pulse_count",        do_pulse_count,  0, 0, 0, {  35,  25,   5, 144 } },
+    { "lmt_get_pulse_count (gap)",  do_pulse_count,  1, 0, 0, {  18,  10,   2,  99 } },
+    { "lmt_get_temperature",        do_temperature,  0, 0, 0, {  35,  25,   5, 144 } },
+    { "lmt_read_start/step",        do_nonblocking,  0, 0, 0, {  30,  25,   5, 144 } },
+    { "lmt_get_pulse_count_multi",  do_multi,        0, 0, 1, {  60,  50,   5, 144 } },
+    { "lmt_sync_read",              do_sync,         0, 0, 1, { 382, 200,  91, 100 } },
+    { "lmt_stream_next",            do_stream,       0, 0, 0, {  40,  16,  12, 114 } },
+    { "lmt_periodic_next",          do_periodic,     0, 0, 0, { 190,  68,  60, 100 } },
+    { "lmt_characterise",           do_characterise, 0, 0, 0, { 568, 198, 185, 203 } },
+    { "lmt_power_cycle",            do_power_cycle,  0, 0, 1, {   6,   0,   1,   5 } },
+};
+
+static uint32_t headroom(uint32_t measured)
+{
+    return measured + (measured * HEADROOM_PCT + 99) / 100;
+}
+
+static void setup(const case_t *c)
+{
+    uint32_t i;
+
+    lmt_sim_reset();
+
+    for (i = 0; i < 2; i++)
+    {
+        lmt_sim_sensor_init(&sensors[i], 25.0f);
+        lmt_sim_dev_init(&devs[i], &timers[i], &sensors[i]);
+
+        if (c->gap_timer)
+        {
+            devs[i].arm_gap_timer = lmt_sim_arm_gap_timer;
+            devs[i].gap_expired = lmt_sim_gap_expired;
+        }
+    }
+
+    /* Second counter on the first sensor, for streaming */
+    timers[2].sensor = &sensors[0];
+    devs[0].timer_b = &timers[2];
+
+    stream = (lmt_stream_t){0};
+    periodic = (lmt_periodic_t){0};
+    sync = (lmt_sync_t){0};
+
+    if (c->fn == do_stream)
+        lmt_stream_start(&devs[0], &stream);
+
+    if (c->fn == do_periodic)
+        lmt_periodic_start(&devs[0], &periodic);
+
+    if (c->fn == do_sync)
+        do_sync();
+
+    for (i = 0; i < 2; i++)
+        lmt_rec_attach(&recs[i], &devs[i]);
+
+    /* delay_ms has no context: log it with the first device, which
+       every case calls */
+    lmt_rec_route_delay(&recs[0]);
+}
+
+/* Calls of one reading: the first device, plus the second for group
+   reads, plus the caller's waits */
+static void total(const case_t *c, lmt_rec_t *sum)
+{
+    uint32_t k;
+
+    *sum = recs[0];
+
+    if (c->group)
+    {
+        for (k = 0; k < LMT_REC_KINDS; k++)
+            sum->counts[k] += recs[1].counts[k];
+
+        sum->waited_us += recs[1].waited_us;
+    }
+
+    sum->counts[LMT_REC_DELAY_MS] += caller_waits;
+    sum->waited_us += caller_waited_us;
+}
+
+int main(void)
+{
+    lmt_rec_t sum;
+    lmt_rec_budget_t worst, budget;
+    uint32_t c, p, timer_ops, waits, wait_ms, failed = 0;
+    uint8_t over, any;
+
+    printf("  %-28s %6s %6s %6s %8s\n", "per call", "calls", "timer", "waits", "wait ms");
+
+    for (c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+    {
+        setup(&cases[c]);
+        worst = (lmt_rec_budget_t){0};
+        budget.max_calls = headroom(cases[c].measured.max_calls);
+        budget.max_timer_ops = headroom(cases[c].measured.max_timer_ops);
+        budget.max_waits = headroom(cases[c].measured.max_waits);
+        budget.max_wait_ms = headroom(cases[c].measured.max_wait_ms);
+        any = 0;
+
+        for (p = 0; p < PHASES; p++)
+        {
+            /* Land at a different point of the sensor cycle each time */
+            lmt_sim_advance_us(PHASE_US + (uint64_t)p * 997);
+
+            if (cases[c].boot)
+            {
+                lmt_sim_set_power(&timers[0], 0);
+                lmt_sim_set_power(&timers[0], 1);
+            }
+            lmt_rec_clear(&recs[0]);
+            lmt_rec_clear(&recs[1]);
+            caller_waits = 0;
+            caller_waited_us = 0;
+
+            if (cases[c].fn() != LMT_OK)
+                any |= 0x80;
+
+            /* A single-device API must not touch the other device */
+            if (!cases[c].group && lmt_rec_calls(&recs[1]) != 0)
+                any |= 0x80;
+
+            total(&cases[c], &sum);
+            timer_ops = sum.counts[LMT_REC_START_TIMER] + sum.counts[LMT_REC_STOP_TIMER] +
+                        sum.counts[LMT_REC_SET_TIMER_CNT] + sum.counts[LMT_REC_GET_TIMER_CNT];
+            waits = sum.counts[LMT_REC_DELAY_MS] + sum.counts[LMT_REC_SLEEP_UNTIL];
+            wait_ms = (uint32_t)((sum.waited_us + 999) / 1000);
+
+            if (lmt_rec_calls(&sum) > worst.max_calls) worst.max_calls = lmt_rec_calls(&sum);
+            if (timer_ops > worst.max_timer_ops) worst.max_timer_ops = timer_ops;
+            if (waits > worst.max_waits) worst.max_waits = waits;
+            if (wait_ms > worst.max_wait_ms) worst.max_wait_ms = wait_ms;
+
+            over = lmt_rec_check(&sum, &budget);
+            any |= over;
+        }
+
+        printf("  %-28s %6u %6u %6u %8u  %s\n", cases[c].name, worst.max_calls,
+               worst.max_timer_ops, worst.max_waits, worst.max_wait_ms,
+               (any & 0x80) ? "FAILED" : (any != 0) ? "OVER BUDGET" : "ok");
+
+        if (any != 0)
+            failed++;
+    }
+
+    return (failed != 0) ? 1 : 0;
+}
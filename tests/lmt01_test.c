@@ -0,0 +1,1064 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        lmt01_test.c
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file lmt01_test.c
+ * @brief Driver tests on the host simulator. Each test returns the number
+ *        of failed checks; the executable exits non-zero if any failed.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "lmt01.h"
+#include "lmt01_sim.h"
+
+#ifdef LMT01_HAVE_ISR
+#include "lmt01_isr.h"
+#endif
+
+/* Phases scanned over one sensor cycle (us apart) */
+#define PHASE_STEP_US   1000
+
+#define CHECK(cond)                                                     \
+    do                                                                  \
+    {                                                                   \
+        if (!(cond))                                                    \
+        {                                                               \
+            printf("    %s:%d: %s\n", __FILE__, __LINE__, #cond);       \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+typedef uint32_t (*test_fptr_t)(void);
+
+static lmt_sim_sensor_t sensor;
+static lmt_sim_timer_t timer;
+static lmt_sim_timer_t timer_b;
+static lmt01_dev_t dev;
+
+/* Fresh simulation: one sensor at temp, powered at time 0 */
+static void setup(float temp)
+{
+    lmt_sim_reset();
+    lmt_sim_sensor_init(&sensor, temp);
+    lmt_sim_dev_init(&dev, &timer, &sensor);
+}
+
+/* A blocking read returns the burst whatever the phase it starts at */
+static uint32_t test_read_every_phase(void)
+{
+    uint32_t failures = 0;
+    uint32_t phase, pulses;
+
+    setup(25.0f);
+
+    for (phase = 0; phase < LMT_SIM_PERIOD_US; phase += PHASE_STEP_US)
+    {
+        lmt_sim_advance_us(LMT_SIM_PERIOD_US * 3 + phase - lmt_sim_now_us() % LMT_SIM_PERIOD_US);
+        pulses = 0;
+        CHECK(lmt_get_pulse_count(&dev, &pulses) == LMT_OK);
+        CHECK(pulses == sensor.pulses);
+    }
+
+    return failures;
+}
+
+/* A powered-up sensor answers the presence check */
+static uint32_t test_init(void)
+{
+    uint32_t failures = 0;
+
+    setup(25.0f);
+    CHECK(lmt_init(&dev) == LMT_OK);
+
+    /* No sensor output */
+    setup(25.0f);
+    sensor.pulses = 0;
+    CHECK(lmt_init(&dev) == LMT_E_DEV_NOT_FOUND);
+
+    return failures;
+}
+
+/* Stepping a context that was never started does not touch the device */
+static uint32_t test_step_not_started(void)
+{
+    uint32_t failures = 0;
+    lmt_read_t rd = {0};
+
+    CHECK(lmt_read_step(&rd) == LMT_E_NULL_PTR);
+
+    setup(25.0f);
+    rd.dev = &dev;
+    CHECK(lmt_read_step(&rd) == LMT_E_INVALID);
+
+    /* Finished: the result again, and the count kept */
+    lmt_sim_advance_us(LMT_SIM_PERIOD_US);
+    CHECK(lmt_read_wait(&dev, &rd) == LMT_OK);
+    CHECK(lmt_read_step(&rd) == LMT_OK);
+    CHECK(rd.pulses == sensor.pulses);
+
+    return failures;
+}
+
+/* Provisional values: a lower bound of the final one from the first
+   step, never the -1 no-pulse sentinel */
+static uint32_t test_provisional_bound(void)
+{
+    uint32_t failures = 0;
+    uint32_t phase, steps;
+    lmt_read_t rd;
+    lmt_status_t rslt;
+    float temp, final;
+
+    for (phase = 0; phase < LMT_SIM_PERIOD_US; phase += 13 * PHASE_STEP_US)
+    {
+        setup(-45.0f);
+        lmt_sim_advance_us(LMT_SIM_PERIOD_US + phase);
+        final = lmt_pulses_to_temperature(sensor.pulses, CONV_TYPE_LUT);
+
+        rd = (lmt_read_t){0};
+        rd.poll_ms = 1;
+        rslt = lmt_read_start(&dev, &rd);
+        steps = 0;
+
+        while (rslt == LMT_BUSY && steps++ < 1000)
+        {
+            CHECK(lmt_read_temperature(&rd, &temp, CONV_TYPE_LUT) == LMT_BUSY);
+            CHECK(temp >= LMT_TEMP_MIN_C && temp <= final);
+
+            lmt_sim_advance_us((uint64_t)rd.wait_ms * 1000);
+            rslt = lmt_read_step(&rd);
+        }
+
+        CHECK(rslt == LMT_OK);
+        CHECK(lmt_read_temperature(&rd, &temp, CONV_TYPE_LUT) == LMT_OK);
+        CHECK(temp == final);
+    }
+
+    return failures;
+}
+
+/* Alarm callbacks seen: count, last count passed and time */
+static uint32_t alarms;
+static uint32_t alarm_pulses;
+static uint64_t alarm_us;
+
+static void on_alarm(void *ctx, uint32_t pulses)
+{
+    (void)ctx;
+
+    alarms++;
+    alarm_pulses = pulses;
+    alarm_us = lmt_sim_now_us();
+}
+
+/* With poll_ms left 0 the alarm still fires mid-burst, once */
+static uint32_t test_alarm_early(void)
+{
+    uint32_t failures = 0;
+    uint32_t phase;
+    lmt_read_t rd;
+
+    for (phase = 0; phase < LMT_SIM_PERIOD_US; phase += 7 * PHASE_STEP_US)
+    {
+        setup(25.0f);
+        lmt_sim_advance_us(LMT_SIM_PERIOD_US + phase);
+
+        rd = (lmt_read_t){0};
+        rd.alarm_pulses = sensor.pulses / 2;
+        rd.alarm_cb = on_alarm;
+        alarms = 0;
+
+        CHECK(lmt_read_wait(&dev, &rd) == LMT_OK);
+        CHECK(rd.pulses == sensor.pulses);
+        CHECK(alarms == 1);
+
+        /* Before the burst ended, so well before the window did */
+        CHECK(alarm_pulses >= rd.alarm_pulses && alarm_pulses < sensor.pulses);
+        CHECK(alarm_us + 5000 < lmt_sim_now_us());
+    }
+
+    /* Threshold at the final count: once; above it: never */
+    setup(25.0f);
+    rd = (lmt_read_t){0};
+    rd.alarm_pulses = sensor.pulses;
+    rd.alarm_cb = on_alarm;
+    alarms = 0;
+    CHECK(lmt_read_wait(&dev, &rd) == LMT_OK);
+    CHECK(alarms == 1);
+    CHECK(alarm_pulses == sensor.pulses);
+
+    rd.alarm_pulses = sensor.pulses + 1;
+    alarms = 0;
+    CHECK(lmt_read_wait(&dev, &rd) == LMT_OK);
+    CHECK(alarms == 0);
+
+    return failures;
+}
+
+/* n readings at spread phases with a health check attached */
+static uint32_t health_reads(lmt_health_t *health, uint32_t n)
+{
+    uint32_t failures = 0;
+    uint32_t i, pulses;
+
+    dev.health = health;
+
+    for (i = 0; i < n; i++)
+    {
+        lmt_sim_advance_us(LMT_SIM_PERIOD_US + 11 * PHASE_STEP_US);
+        pulses = 0;
+        CHECK(lmt_get_pulse_count(&dev, &pulses) == LMT_OK);
+        CHECK(pulses == sensor.pulses);
+    }
+
+    return failures;
+}
+
+/* The burst signature passes at the nominal rate and fails detuned,
+   the score following */
+static uint32_t test_health_signature(void)
+{
+    uint32_t failures = 0;
+    lmt_health_t health = {0};
+    uint8_t score;
+
+    setup(25.0f);
+    failures += health_reads(&health, 8);
+
+    CHECK(health.checks == 8 && health.faults == 0);
+    CHECK(health.status == LMT_OK);
+    CHECK(health.score == 100);
+    CHECK(health.freq_hz > LMT_SIM_FREQ_HZ * 98 / 100 && health.freq_hz < LMT_SIM_FREQ_HZ * 102 / 100);
+    CHECK(health.burst_us > sensor.pulses * 1000000ull / LMT_SIM_FREQ_HZ * 98 / 100 &&
+          health.burst_us < sensor.pulses * 1000000ull / LMT_SIM_FREQ_HZ * 102 / 100);
+
+    /* 20% slow, outside the default tolerance */
+    sensor.freq_hz = LMT_SIM_FREQ_HZ * 8 / 10;
+    failures += health_reads(&health, 8);
+
+    CHECK(health.checks == 16 && health.faults == 8);
+    CHECK(health.status == LMT_E_SIGNATURE);
+    CHECK(health.freq_hz > sensor.freq_hz * 98 / 100 && health.freq_hz < sensor.freq_hz * 102 / 100);
+    CHECK(health.score < 50);
+
+    /* Back in tune: passes again and the score recovers */
+    score = health.score;
+    sensor.freq_hz = LMT_SIM_FREQ_HZ;
+    failures += health_reads(&health, 4);
+
+    CHECK(health.faults == 8);
+    CHECK(health.status == LMT_OK);
+    CHECK(health.score > score);
+
+    /* A wider tolerance accepts the slow sensor */
+    health = (lmt_health_t){0};
+    health.tol_pct = 25;
+    sensor.freq_hz = LMT_SIM_FREQ_HZ * 8 / 10;
+    failures += health_reads(&health, 2);
+
+    CHECK(health.checks == 2 && health.faults == 0);
+    CHECK(health.status == LMT_OK);
+
+    return failures;
+}
+
+/* A burst too short for two mid-burst samples is not checked */
+static uint32_t test_health_short_burst(void)
+{
+    uint32_t failures = 0;
+    lmt_health_t health = {0};
+
+    setup(25.0f);
+    sensor.pulses = 20;
+    failures += health_reads(&health, 4);
+
+    CHECK(health.checks == 0 && health.faults == 0);
+    CHECK(health.freq_hz == 0 && health.score == 0);
+    CHECK(health.status == LMT_OK);
+
+    /* A checked reading is not undone by a short one */
+    sensor.pulses = 2000;
+    failures += health_reads(&health, 1);
+    CHECK(health.checks == 1);
+
+    sensor.pulses = 20;
+    failures += health_reads(&health, 2);
+    CHECK(health.checks == 1 && health.score == 100);
+    CHECK(health.burst_us > 2000 * 1000000ull / LMT_SIM_FREQ_HZ * 98 / 100);
+
+    return failures;
+}
+
+/* Characterised windows read the burst at every phase, at the ends of
+   the range and in the middle */
+static uint32_t test_characterised_every_phase(void)
+{
+    static const float temps[] = { -40.0f, 25.0f, 150.0f };
+    uint32_t failures = 0;
+    uint32_t i, phase, pulses;
+    lmt_state_t state;
+
+    for (i = 0; i < sizeof(temps) / sizeof(temps[0]); i++)
+    {
+        setup(temps[i]);
+        state = (lmt_state_t){0};
+        dev.state = &state;
+        lmt_sim_advance_us(LMT_SIM_PERIOD_US);
+
+        CHECK(lmt_characterise(&dev, NULL) == LMT_OK);
+        CHECK(state.timing.capture_ms < LMT_SIM_PERIOD_US / 1000);
+        CHECK(state.timing.drain_ms < LMT_DRAIN_PERIOD_MS);
+
+        for (phase = 0; phase < LMT_SIM_PERIOD_US; phase += PHASE_STEP_US / 4)
+        {
+            lmt_sim_advance_us(LMT_SIM_PERIOD_US * 2 + phase - lmt_sim_now_us() % LMT_SIM_PERIOD_US);
+            pulses = 0;
+            CHECK(lmt_get_pulse_count(&dev, &pulses) == LMT_OK);
+            CHECK(pulses == sensor.pulses);
+        }
+    }
+
+    return failures;
+}
+
+/* With the gap timer hooks a blocking read ends with the burst instead
+   of waiting out the capture window */
+static uint32_t test_gap_timer_shortens_read(void)
+{
+    uint32_t failures = 0;
+    uint32_t phase, pulses, gap, sleeps, max_sleeps[2] = {0, 0};
+    uint64_t t, plain_us = 0, gap_us = 0;
+
+    for (gap = 0; gap < 2; gap++)
+    {
+        setup(25.0f);
+
+        if (gap)
+        {
+            dev.arm_gap_timer = lmt_sim_arm_gap_timer;
+            dev.gap_expired = lmt_sim_gap_expired;
+        }
+
+        for (phase = 0; phase < LMT_SIM_PERIOD_US; phase += PHASE_STEP_US)
+        {
+            lmt_sim_advance_us(LMT_SIM_PERIOD_US * 2 + phase - lmt_sim_now_us() % LMT_SIM_PERIOD_US);
+            t = lmt_sim_now_us();
+            sleeps = lmt_sim_power()->sleeps;
+            pulses = 0;
+            CHECK(lmt_get_pulse_count(&dev, &pulses) == LMT_OK);
+            CHECK(pulses == sensor.pulses);
+            *(gap ? &gap_us : &plain_us) += lmt_sim_now_us() - t;
+
+            sleeps = lmt_sim_power()->sleeps - sleeps;
+            if (sleeps > max_sleeps[gap])
+                max_sleeps[gap] = sleeps;
+        }
+    }
+
+    /* On average the burst ends half a cycle before the window does */
+    CHECK(gap_us < plain_us * 3 / 4);
+
+    /* The capture is one sleep, ended by the gap timer */
+    CHECK(max_sleeps[1] <= max_sleeps[0]);
+
+    return failures;
+}
+
+/* The gap timer interrupt finishes a non-blocking reading at burst end */
+static uint32_t test_gap_irq(void)
+{
+    uint32_t failures = 0;
+    uint32_t phase, polls;
+    uint64_t timeout;
+    lmt_read_t rd;
+    lmt_status_t rslt;
+
+    for (phase = 0; phase < LMT_SIM_PERIOD_US; phase += PHASE_STEP_US * 7)
+    {
+        setup(25.0f);
+        dev.arm_gap_timer = lmt_sim_arm_gap_timer;
+        dev.gap_expired = lmt_sim_gap_expired;
+        lmt_sim_advance_us(LMT_SIM_PERIOD_US * 2 + phase);
+
+        memset(&rd, 0, sizeof(rd));
+        CHECK(lmt_read_gap_irq(&rd) == LMT_E_NULL_PTR);
+
+        rslt = lmt_read_start(&dev, &rd);
+        CHECK(lmt_read_gap_irq(&rd) == rslt);
+
+        while (rslt == LMT_BUSY && rd.state != LMT_READ_CAPTURE)
+        {
+            lmt_sim_advance_us((uint64_t)rd.wait_ms * 1000);
+            rslt = lmt_read_step(&rd);
+        }
+
+        CHECK(rslt == LMT_BUSY);
+
+        /* Interrupts before the burst has ended change nothing */
+        timeout = lmt_sim_now_us() + (uint64_t)rd.wait_ms * 1000;
+        polls = 0;
+
+        while ((rslt = lmt_read_gap_irq(&rd)) == LMT_BUSY &&
+               lmt_sim_now_us() < timeout)
+        {
+            lmt_sim_advance_us(100);
+            polls++;
+        }
+
+        CHECK(rslt == LMT_OK);
+        CHECK(polls > 0);
+        CHECK(lmt_sim_now_us() < timeout);
+        CHECK(rd.pulses == sensor.pulses);
+        CHECK(rd.state == LMT_READ_DONE);
+
+        /* A late interrupt, or the timeout step, reports it again */
+        CHECK(lmt_read_gap_irq(&rd) == LMT_OK);
+        CHECK(lmt_read_step(&rd) == LMT_OK);
+        CHECK(rd.pulses == sensor.pulses);
+    }
+
+    return failures;
+}
+
+/* Second counter on the sensor, for streaming */
+static void setup_stream(float temp)
+{
+    setup(temp);
+    memset(&timer_b, 0, sizeof(timer_b));
+    timer_b.sensor = &sensor;
+    dev.timer_b = &timer_b;
+}
+
+/* Across the timer switches every pulse is counted once and no burst is
+   split, whether the stream period matches the sensor's or not */
+static uint32_t test_stream_no_loss(void)
+{
+    static const uint32_t periods[] = { 0, 100, 104, 110, 300 };
+    uint32_t failures = 0;
+    uint32_t p, i, phase, pulses, total;
+    uint64_t start;
+    lmt_stream_t st;
+    lmt_status_t rslt;
+
+    for (p = 0; p < sizeof(periods) / sizeof(periods[0]); p++)
+    {
+        for (phase = 0; phase < LMT_SIM_PERIOD_US; phase += PHASE_STEP_US * 13)
+        {
+            setup_stream(25.0f);
+            lmt_sim_advance_us(LMT_SIM_PERIOD_US + phase);
+
+            memset(&st, 0, sizeof(st));
+            st.period_ms = periods[p];
+            CHECK(lmt_stream_start(&dev, &st) == LMT_OK);
+            start = lmt_sim_now_us();
+            total = 0;
+
+            for (i = 0; i < 20; i++)
+            {
+                pulses = 0;
+                rslt = lmt_stream_next(&dev, &st, &pulses);
+                CHECK(rslt == LMT_OK || rslt == LMT_E_DEV_NOT_FOUND);
+                CHECK(pulses % sensor.pulses == 0);
+
+                /* One burst per period unless the periods differ */
+                if (periods[p] == 0 || periods[p] == 104)
+                    CHECK(pulses == sensor.pulses);
+
+                total += pulses;
+            }
+
+            CHECK(total == lmt_sim_pulses_before(&sensor, lmt_sim_now_us()) -
+                           lmt_sim_pulses_before(&sensor, start));
+        }
+    }
+
+    return failures;
+}
+
+/* Sensor pulsing all the time, no gap between bursts */
+static void setup_stuck(void)
+{
+    setup_stream(25.0f);
+    sensor.conv_us = 0;
+    sensor.pulses = (uint32_t)((uint64_t)sensor.period_us * sensor.freq_hz / 1000000);
+    lmt_sim_advance_us(LMT_SIM_PERIOD_US);
+}
+
+/* Every wait for a quiet line gives up after about a sensor cycle */
+static uint32_t test_drain_bounded(void)
+{
+    uint32_t failures = 0;
+    const lmt01_dev_t *devs[1] = { &dev };
+    uint32_t pulses[1];
+    lmt_status_t rslts[1];
+    lmt_stream_t st = {0};
+    lmt_periodic_t pd = {0};
+    lmt_read_t rd = {0};
+    lmt_status_t rslt;
+    uint64_t start;
+    uint32_t steps = 0;
+
+#define BOUNDED(call, limit_us)                                         \
+    do                                                                  \
+    {                                                                   \
+        setup_stuck();                                                  \
+        start = lmt_sim_now_us();                                       \
+        CHECK((call) == LMT_E_TIMEOUT);                                 \
+        CHECK(lmt_sim_now_us() - start < (limit_us));                   \
+    } while (0)
+
+    BOUNDED(lmt_get_pulse_count(&dev, pulses), 2 * LMT_SIM_PERIOD_US);
+    BOUNDED(lmt_get_pulse_count_multi(devs, 1, pulses, rslts), 2 * LMT_SIM_PERIOD_US);
+    CHECK(rslts[0] == LMT_E_TIMEOUT && pulses[0] == 0);
+    BOUNDED(lmt_stream_start(&dev, &st), 2 * LMT_SIM_PERIOD_US);
+    BOUNDED(lmt_periodic_start(&dev, &pd), 2 * LMT_SIM_PERIOD_US);
+
+    /* Characterising, the period is not known yet */
+    BOUNDED(lmt_characterise(&dev, NULL), (LMT_TIMING_MAX_MS + 2 * LMT_DRAIN_PERIOD_MS) * 1000);
+
+    /* The grid comes from a good start, then the line sticks */
+    pd.cycle_us = pd.period_us = LMT_SIM_PERIOD_US;
+    BOUNDED(lmt_periodic_next(&dev, &pd, pulses), 2 * LMT_SIM_PERIOD_US);
+
+#undef BOUNDED
+
+    /* Non-blocking: bounded in steps too */
+    setup_stuck();
+    rslt = lmt_read_start(&dev, &rd);
+
+    while (rslt == LMT_BUSY && steps++ < 100)
+    {
+        lmt_sim_advance_us((uint64_t)rd.wait_ms * 1000);
+        rslt = lmt_read_step(&rd);
+    }
+
+    CHECK(rslt == LMT_E_TIMEOUT);
+    CHECK(rd.rslt == LMT_E_TIMEOUT && rd.state == LMT_READ_DONE);
+    CHECK(steps < 20);
+
+    return failures;
+}
+
+/* A line that never goes quiet holds the switch for one cycle at most */
+static uint32_t test_stream_stuck_line(void)
+{
+    uint32_t failures = 0;
+    uint32_t pulses = 0;
+    uint64_t start;
+    lmt_stream_t st = {0};
+
+    setup_stuck();
+    lmt_sim_start_timer(&timer);
+
+    start = lmt_sim_now_us();
+    CHECK(lmt_stream_next(&dev, &st, &pulses) == LMT_E_TIMEOUT);
+    CHECK(pulses != 0);
+    CHECK(st.active == 1);
+    CHECK(lmt_sim_now_us() - start < 2 * LMT_SIM_PERIOD_US + 10000);
+
+    return failures;
+}
+
+/* Expected jitter_us after steps grid points: the grid runs at the
+   measured cycle, the sensor at its own */
+static int32_t grid_drift(const lmt_periodic_t *pd, uint32_t steps)
+{
+    uint32_t cycles = pd->period_us / pd->cycle_us;
+
+    return (int32_t)(steps * (cycles * LMT_SIM_PERIOD_US - pd->period_us));
+}
+
+#define ON_GRID(pd, steps, from)                                        \
+    ((pd).jitter_us - (from) - grid_drift(&(pd), steps) >= -1000 &&     \
+     (pd).jitter_us - (from) - grid_drift(&(pd), steps) <= 1000)
+
+/* Samples stay on the grid of burst starts while the burst length
+   changes with temperature, a late caller skips points, and the period
+   is whole sensor cycles */
+static uint32_t test_periodic_grid(void)
+{
+    static const uint32_t periods[][2] = { { 0, 1 }, { 30, 1 }, { 250, 2 }, { 270, 3 }, { 1000, 10 } };
+    uint32_t failures = 0;
+    uint32_t i, pulses, grid;
+    int32_t prev;
+    lmt_periodic_t pd;
+
+    setup(25.0f);
+    pd = (lmt_periodic_t){0};
+    CHECK(lmt_periodic_start(&dev, &pd) == LMT_OK);
+    CHECK(pd.cycle_us > LMT_SIM_PERIOD_US - 1000 && pd.cycle_us < LMT_SIM_PERIOD_US + 1000);
+    CHECK(pd.period_us == pd.cycle_us);
+
+    /* Bursts of 9 ms and 40 ms in turn, every cycle. The jitter only
+       follows the cycle measuring error, not the burst length. */
+    prev = 0;
+
+    for (i = 0; i < 10; i++)
+    {
+        sensor.pulses = (i & 1) ? 800 : 3500;
+        grid = pd.grid_us;
+        CHECK(lmt_periodic_next(&dev, &pd, &pulses) == LMT_OK);
+        CHECK(pulses == sensor.pulses);
+        CHECK(pd.grid_us - grid == pd.period_us);
+        CHECK(ON_GRID(pd, 1, prev));
+        prev = pd.jitter_us;
+    }
+
+    CHECK(pd.samples == 10 && pd.skipped == 0);
+
+    /* Three cycles late: three points skipped, still on the grid */
+    lmt_sim_advance_us(3 * (uint64_t)pd.period_us);
+    grid = pd.grid_us;
+    CHECK(lmt_periodic_next(&dev, &pd, &pulses) == LMT_OK);
+    CHECK(pd.skipped == 3);
+    CHECK(pd.grid_us - grid == 4 * pd.period_us);
+    CHECK(ON_GRID(pd, 4, prev));
+
+    /* period_ms rounded to the nearest whole cycle, at least one */
+    for (i = 0; i < sizeof(periods) / sizeof(periods[0]); i++)
+    {
+        pd = (lmt_periodic_t){0};
+        pd.period_ms = periods[i][0];
+        CHECK(lmt_periodic_start(&dev, &pd) == LMT_OK);
+        CHECK(pd.period_us == periods[i][1] * pd.cycle_us);
+
+        grid = pd.grid_us;
+        CHECK(lmt_periodic_next(&dev, &pd, &pulses) == LMT_OK);
+        CHECK(pd.grid_us - grid == pd.period_us);
+        CHECK(ON_GRID(pd, 1, 0));
+    }
+
+    return failures;
+}
+
+#undef ON_GRID
+
+/* Memory-mapped counter for the register path. The enable bits are
+   set alongside unrelated ones. */
+#define REG_EN_MASK     0x05u
+#define REG_EN_OTHER    0x80u
+
+static volatile uint32_t reg_cnt;
+static volatile uint32_t reg_en;
+static uint8_t reg_running;
+static uint32_t reg_base, reg_last;
+static uint64_t reg_since;
+
+/* Waits are the only place time passes (hal_us is 0), so the counter
+   register is brought up to date around each one. A count that changed
+   since the last update was written by the driver. */
+static void reg_before(void)
+{
+    uint8_t on = (reg_en & REG_EN_MASK) == REG_EN_MASK;
+
+    if (on && (!reg_running || reg_cnt != reg_last))
+    {
+        reg_base = reg_cnt;
+        reg_since = lmt_sim_now_us();
+    }
+
+    reg_running = on;
+}
+
+static void reg_after(void)
+{
+    if (reg_running)
+        reg_cnt = reg_base + (uint32_t)(lmt_sim_pulses_before(&sensor, lmt_sim_now_us()) -
+                                        lmt_sim_pulses_before(&sensor, reg_since));
+
+    reg_last = reg_cnt;
+}
+
+static void reg_delay_ms(uint32_t ms)
+{
+    reg_before();
+    lmt_sim_delay_ms(ms);
+    reg_after();
+}
+
+static void reg_sleep_until(void *timer, uint32_t wake_us)
+{
+    reg_before();
+    lmt_sim_sleep_until(timer, wake_us);
+    reg_after();
+}
+
+/* The count and enable registers replace the timer callbacks, which are
+   left NULL, and only the enable bits are touched */
+static uint32_t test_direct_registers(void)
+{
+    uint32_t failures = 0;
+    uint32_t phase, pulses;
+
+    setup(25.0f);
+    lmt_sim_power()->hal_us = 0;
+
+    dev.start_timer = NULL;
+    dev.stop_timer = NULL;
+    dev.set_timer_cnt = NULL;
+    dev.get_timer_cnt = NULL;
+    dev.cnt_reg = (volatile uint32_t *)&reg_cnt;
+    dev.en_reg = (volatile uint32_t *)&reg_en;
+    dev.en_mask = REG_EN_MASK;
+    dev.delay_ms = reg_delay_ms;
+    dev.sleep_until = reg_sleep_until;
+
+    reg_cnt = reg_last = 12345;
+    reg_en = REG_EN_OTHER;
+    reg_running = 0;
+
+    CHECK(lmt_init(&dev) == LMT_OK);
+    CHECK(reg_en == REG_EN_OTHER);
+
+    for (phase = 0; phase < LMT_SIM_PERIOD_US; phase += 3 * PHASE_STEP_US)
+    {
+        lmt_sim_advance_us(LMT_SIM_PERIOD_US * 2 + phase - lmt_sim_now_us() % LMT_SIM_PERIOD_US);
+        pulses = 0;
+        CHECK(lmt_get_pulse_count(&dev, &pulses) == LMT_OK);
+        CHECK(pulses == sensor.pulses);
+        CHECK(reg_en == REG_EN_OTHER);
+    }
+
+    /* No sensor output */
+    sensor.pulses = 0;
+    CHECK(lmt_get_pulse_count(&dev, &pulses) == LMT_E_DEV_NOT_FOUND);
+    CHECK(reg_en == REG_EN_OTHER);
+
+    /* Without the registers the callbacks are required */
+    dev.cnt_reg = NULL;
+    CHECK(lmt_get_pulse_count(&dev, &pulses) == LMT_E_NULL_PTR);
+    dev.cnt_reg = (volatile uint32_t *)&reg_cnt;
+    dev.en_reg = NULL;
+    CHECK(lmt_get_pulse_count(&dev, &pulses) == LMT_E_NULL_PTR);
+
+    return failures;
+}
+
+#ifdef LMT01_HAVE_ISR
+/* The software counter drops edges too close to the last accepted one,
+   and only counts while started */
+static uint32_t test_isr_edge(void)
+{
+    uint32_t failures = 0;
+    lmt_isr_counter_t ctr = {0};
+    uint32_t cnt = 0;
+
+    ctr.min_interval_us = 8;
+
+    /* Stopped: edges are neither counted nor tallied */
+    lmt_isr_edge(&ctr, 100);
+    CHECK(ctr.count == 0 && ctr.glitches == 0);
+
+    lmt_isr_start_timer(&ctr);
+    lmt_isr_edge(&ctr, 1000);
+    lmt_isr_edge(&ctr, 1003);      /* ringing */
+    lmt_isr_edge(&ctr, 1007);      /* still ringing */
+    lmt_isr_edge(&ctr, 1008);      /* min_interval_us after the first */
+    lmt_isr_edge(&ctr, 1019);
+    lmt_isr_get_timer_cnt(&ctr, &cnt);
+    CHECK(cnt == 3 && ctr.glitches == 2);
+
+    /* The interval is from the last accepted edge, across a wrap */
+    lmt_isr_edge(&ctr, 1026);
+    CHECK(ctr.count == 3 && ctr.glitches == 3);
+    ctr.last_us = UINT32_MAX - 2;
+    lmt_isr_edge(&ctr, 3);
+    lmt_isr_edge(&ctr, 6);
+    CHECK(ctr.count == 4 && ctr.glitches == 4);
+
+    lmt_isr_stop_timer(&ctr);
+    lmt_isr_edge(&ctr, 100);
+    CHECK(ctr.count == 4 && ctr.glitches == 4);
+
+    /* A new window accepts its first edge whenever it comes */
+    cnt = 0;
+    lmt_isr_set_timer_cnt(&ctr, &cnt);
+    lmt_isr_start_timer(&ctr);
+    lmt_isr_edge(&ctr, 8);
+    CHECK(ctr.count == 1 && ctr.glitches == 4);
+
+    /* Filter off: every edge counts */
+    ctr.min_interval_us = 0;
+    lmt_isr_edge(&ctr, 8);
+    lmt_isr_edge(&ctr, 9);
+    CHECK(ctr.count == 3 && ctr.glitches == 4);
+
+    return failures;
+}
+#endif
+
+/* Lazy init keeps the other flags; the first reading settles presence */
+static uint32_t test_lazy_presence(void)
+{
+    uint32_t failures = 0;
+    uint32_t pulses;
+    lmt_state_t state = {0};
+
+    setup(25.0f);
+    dev.state = &state;
+    lmt_sim_advance_us(LMT_SIM_PERIOD_US);
+
+    CHECK(lmt_characterise(&dev, NULL) == LMT_OK);
+    CHECK(lmt_init_lazy(&dev) == LMT_OK);
+    CHECK(state.flags == (LMT_STATE_TIMED | LMT_STATE_PRESENT));
+    CHECK(lmt_presence(&dev) == LMT_OK);
+
+    /* Unknown device: pending until the first reading */
+    state = (lmt_state_t){0};
+    CHECK(lmt_init_lazy(&dev) == LMT_OK);
+    CHECK(lmt_presence(&dev) == LMT_BUSY);
+    CHECK(lmt_get_pulse_count(&dev, &pulses) == LMT_OK);
+    CHECK(lmt_presence(&dev) == LMT_OK);
+    CHECK(!(state.flags & LMT_STATE_LAZY));
+
+    /* No output: the first reading is the failed presence check */
+    state = (lmt_state_t){0};
+    sensor.pulses = 0;
+    CHECK(lmt_init_lazy(&dev) == LMT_OK);
+    CHECK(lmt_get_pulse_count(&dev, &pulses) == LMT_E_DEV_NOT_FOUND);
+    CHECK(lmt_presence(&dev) == LMT_E_DEV_NOT_FOUND);
+
+    return failures;
+}
+
+/* lmt_init and lmt_init_multi leave the same state */
+static uint32_t test_init_multi_state(void)
+{
+    uint32_t failures = 0;
+    lmt_state_t state = {0};
+    const lmt01_dev_t *devs[1] = { &dev };
+
+    setup(25.0f);
+    dev.state = &state;
+    CHECK(lmt_init_multi(devs, 1, NULL) == LMT_OK);
+    CHECK(state.flags == LMT_STATE_PRESENT);
+
+    setup(25.0f);
+    sensor.pulses = 0;
+    dev.state = &state;
+    CHECK(lmt_init_multi(devs, 1, NULL) == LMT_E_DEV_NOT_FOUND);
+    CHECK(lmt_presence(&dev) == LMT_E_DEV_NOT_FOUND);
+
+    return failures;
+}
+
+/* A failed group read closes the meter; a group that never goes quiet
+   times out instead of draining for ever */
+static uint32_t test_sync_read_fails(void)
+{
+    uint32_t failures = 0;
+    const lmt01_dev_t *devs[1] = { &dev };
+    lmt_energy_t meter = {0};
+    lmt_sync_t sync = {0};
+    lmt_status_t rslts[1];
+    uint32_t pulses[1];
+
+    CHECK(lmt_sync_read(NULL, 1, &sync, pulses, rslts) == LMT_E_NULL_PTR);
+    CHECK(sync.resyncs == 0);
+
+    /* No supply switch: the power cycle fails */
+    setup(25.0f);
+    dev.set_power = NULL;
+    dev.energy = &meter;
+    CHECK(lmt_sync_read(devs, 1, &sync, pulses, rslts) == LMT_E_NULL_PTR);
+    CHECK(rslts[0] == LMT_E_NULL_PTR);
+    CHECK(meter.readings == 1);
+
+    /* Pulsing all the time */
+    setup(25.0f);
+    sensor.conv_us = 0;
+    sensor.pulses = (uint32_t)((uint64_t)sensor.period_us * sensor.freq_hz / 1000000);
+    dev.energy = &meter;
+    sync.synced = 1;
+    lmt_sim_advance_us(LMT_SIM_PERIOD_US);
+    CHECK(lmt_sync_read(devs, 1, &sync, pulses, rslts) == LMT_E_TIMEOUT);
+    CHECK(rslts[0] == LMT_E_TIMEOUT && pulses[0] == 0);
+    CHECK(meter.readings == 2);
+    CHECK(sync.synced == 0);
+
+    return failures;
+}
+
+/* The group drain waits out bursts longer than the default window */
+static uint32_t test_sync_read_long_burst(void)
+{
+    uint32_t failures = 0;
+    const lmt01_dev_t *devs[1] = { &dev };
+    lmt_state_t state = {0};
+    lmt_sync_t sync = {0};
+    lmt_status_t rslts[1];
+    uint32_t pulses[1], phase;
+
+    setup(25.0f);
+    sensor.period_us = 240000;
+    sensor.conv_us = 100000;
+    sensor.freq_hz = sensor.pulses * 1000 / 130;
+    lmt_sim_advance_us(sensor.period_us);
+
+    /* As lmt_characterise would derive it */
+    state.timing.init_ms = 112;
+    state.timing.drain_ms = 10;
+    state.timing.capture_ms = 232;
+    state.timing.period_ms = 240;
+    state.timing.burst_ms = 130;
+    state.timing.freq_hz = sensor.freq_hz;
+    state.flags = LMT_STATE_TIMED | LMT_STATE_PRESENT;
+    dev.state = &state;
+
+    for (phase = 0; phase < sensor.period_us; phase += PHASE_STEP_US * 10)
+    {
+        lmt_sim_advance_us(sensor.period_us * 2 + phase - lmt_sim_now_us() % sensor.period_us);
+        sync.synced = 1;
+        CHECK(lmt_sync_read(devs, 1, &sync, pulses, rslts) == LMT_OK);
+        CHECK(pulses[0] == sensor.pulses);
+    }
+
+    return failures;
+}
+
+/* A restored characterised device reads its first burst without
+   lmt_init or a second cycle: at worst a drain before the burst starts,
+   the burst, a drain overlapping its end, a quiet drain and a capture */
+static uint32_t test_restore_first_read(void)
+{
+    uint32_t failures = 0;
+    uint8_t blob[LMT_STATE_BLOB_LEN];
+    lmt_state_t saved = {0}, state;
+    uint32_t phase, pulses;
+    uint64_t t0, limit_us;
+
+    setup(25.0f);
+    dev.state = &saved;
+    lmt_sim_advance_us(LMT_SIM_PERIOD_US);
+    CHECK(lmt_characterise(&dev, NULL) == LMT_OK);
+    CHECK(lmt_state_save(&saved, blob, sizeof(blob)) == LMT_OK);
+
+    limit_us = ((uint64_t)saved.timing.burst_ms + 3 * saved.timing.drain_ms +
+                saved.timing.capture_ms + 2 * LMT_PROBE_POLL_MS) * 1000;
+
+    for (phase = 0; phase < LMT_SIM_PERIOD_US; phase += 3 * PHASE_STEP_US)
+    {
+        /* After a reset: new state, sensor still running */
+        setup(25.0f);
+        state = (lmt_state_t){0};
+        dev.state = &state;
+        CHECK(lmt_state_restore(&state, blob, sizeof(blob)) == LMT_OK);
+        CHECK(lmt_presence(&dev) == LMT_OK);
+
+        lmt_sim_advance_us(2 * LMT_SIM_PERIOD_US + phase);
+        t0 = lmt_sim_now_us();
+        pulses = 0;
+        CHECK(lmt_get_pulse_count(&dev, &pulses) == LMT_OK);
+        CHECK(pulses == sensor.pulses);
+        CHECK(lmt_sim_now_us() - t0 <= limit_us);
+    }
+
+    return failures;
+}
+
+/* Restored timing that would miss or split a burst is not used */
+static uint32_t test_restore_bad_timing(void)
+{
+    static const lmt_timing_t bad[] = {
+        { 60, 4,   0, 104, 27, 88000 },     /* No capture window */
+        { 60, 4, 240, 104, 27, 88000 },     /* Holds two bursts */
+        { 60, 4,  60, 104, 27, 88000 },     /* Misses the burst */
+        { 60, 4, 102, 104,  0, 88000 },     /* No burst */
+        { 60, 4, 102,  20, 27, 88000 },     /* Burst longer than period */
+    };
+    uint32_t failures = 0;
+    uint8_t blob[LMT_STATE_BLOB_LEN];
+    lmt_state_t saved, state;
+    uint32_t i;
+
+    for (i = 0; i < sizeof(bad) / sizeof(bad[0]); i++)
+    {
+        saved = (lmt_state_t){0};
+        saved.flags = LMT_STATE_TIMED | LMT_STATE_PRESENT;
+        saved.timing = bad[i];
+        CHECK(lmt_state_save(&saved, blob, sizeof(blob)) == LMT_OK);
+        CHECK(lmt_state_restore(&state, blob, sizeof(blob)) == LMT_OK);
+        CHECK(state.flags == LMT_STATE_PRESENT);
+    }
+
+    /* What lmt_characterise gives is kept */
+    saved.timing = (lmt_timing_t){ 60, 4, 102, 104, 27, 88000 };
+    CHECK(lmt_state_save(&saved, blob, sizeof(blob)) == LMT_OK);
+    CHECK(lmt_state_restore(&state, blob, sizeof(blob)) == LMT_OK);
+    CHECK(state.flags == (LMT_STATE_TIMED | LMT_STATE_PRESENT));
+
+    return failures;
+}
+
+static const struct
+{
+    const char *name;
+    test_fptr_t fn;
+} tests[] = {
+    { "read_every_phase",          test_read_every_phase },
+    { "init",                      test_init },
+    { "step_not_started",          test_step_not_started },
+    { "characterised_every_phase", test_characterised_every_phase },
+    { "gap_timer_shortens_read",   test_gap_timer_shortens_read },
+    { "gap_irq",                   test_gap_irq },
+    { "provisional_bound",         test_provisional_bound },
+    { "alarm_early",               test_alarm_early },
+    { "health_signature",          test_health_signature },
+    { "health_short_burst",        test_health_short_burst },
+    { "sync_read_fails",           test_sync_read_fails },
+    { "sync_read_long_burst",      test_sync_read_long_burst },
+    { "restore_first_read",        test_restore_first_read },
+    { "restore_bad_timing",        test_restore_bad_timing },
+    { "drain_bounded",             test_drain_bounded },
+    { "stream_no_loss",            test_stream_no_loss },
+    { "stream_stuck_line",         test_stream_stuck_line },
+    { "periodic_grid",             test_periodic_grid },
+    { "direct_registers",          test_direct_registers },
+#ifdef LMT01_HAVE_ISR
+    { "isr_edge",                  test_isr_edge },
+#endif
+    { "lazy_presence",             test_lazy_presence },
+    { "init_multi_state",          test_init_multi_state },
+};
+
+int main(void)
+{
+    uint32_t i, failed = 0, n;
+
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+    {
+        n = tests[i].fn();
+        printf("%-28s %s\n", tests[i].name, n ? "FAILED" : "ok");
+
+        if (n != 0)
+            failed++;
+    }
+
+    return (failed != 0) ? 1 : 0;
+}
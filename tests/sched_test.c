@@ -0,0 +1,291 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * 
+ * File        sched_test.c
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file sched_test.c
+ * @brief Deadline scheduler tests on simulated sensors: EDF order,
+ *        priority under overload, shedding and failed readings.
+ */
+#include <stdio.h>
+
+#include "lmt01_sched.h"
+#include "lmt01_sim.h"
+
+#define CHECK(cond)                                                     \
+    do                                                                  \
+    {                                                                   \
+        if (!(cond))                                                    \
+        {                                                               \
+            printf("    %s:%d: %s\n", __FILE__, __LINE__, #cond);       \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+#define TASKS       12
+#define LOG         64
+
+typedef uint32_t (*test_fptr_t)(void);
+
+static lmt_sim_sensor_t sensors[TASKS];
+static lmt_sim_timer_t timers[TASKS];
+static lmt01_dev_t devs[TASKS];
+static lmt_sched_task_t tasks[TASKS];
+static lmt_sched_t sched;
+
+/* Completions seen: task index, result and lateness */
+static uint32_t logged;
+static uint32_t log_id[LOG];
+static lmt_status_t log_rslt[LOG];
+static uint8_t log_late[LOG];
+
+static void on_done(void *ctx, lmt_status_t rslt, uint32_t pulses, uint8_t late)
+{
+    (void)pulses;
+
+    if (logged < LOG)
+    {
+        log_id[logged] = (uint32_t)((lmt_sched_task_t *)ctx - tasks);
+        log_rslt[logged] = rslt;
+        log_late[logged] = late;
+    }
+
+    logged++;
+}
+
+/* n sensors at 25 *C with spread phases, and an initialised scheduler
+   of tasks of the given period, all released at 0 */
+static void setup(uint32_t n, uint32_t period_ms)
+{
+    uint32_t i;
+
+    lmt_sim_reset();
+    logged = 0;
+
+    for (i = 0; i < n; i++)
+    {
+        lmt_sim_sensor_init(&sensors[i], 25.0f);
+        sensors[i].phase_us = (uint64_t)i * 6500;
+        lmt_sim_dev_init(&devs[i], &timers[i], &sensors[i]);
+
+        tasks[i] = (lmt_sched_task_t){0};
+        tasks[i].dev = &devs[i];
+        tasks[i].period_ms = period_ms;
+        tasks[i].done_cb = on_done;
+        tasks[i].done_ctx = &tasks[i];
+    }
+
+    lmt_sched_init(&sched, tasks, n, 0);
+}
+
+/* Poll the scheduler on the simulated clock until end_ms */
+static void run(uint32_t end_ms)
+{
+    uint32_t now = 0, wait;
+
+    while (now < end_ms)
+    {
+        wait = lmt_sched_poll(&sched, now);
+        lmt_sim_advance_us((uint64_t)wait * 1000);
+        now += wait;
+    }
+}
+
+/* Every released job is accounted for exactly once */
+static uint8_t conserved(uint32_t n)
+{
+    uint32_t i;
+
+    for (i = 0; i < n; i++)
+    {
+        if (tasks[i].released != tasks[i].done + tasks[i].failed + tasks[i].misses +
+                                 tasks[i].pending + (sched.running == &tasks[i]))
+            return 0;
+    }
+
+    return 1;
+}
+
+static uint32_t test_edf_order(void)
+{
+    uint32_t failures = 0;
+    uint32_t i;
+
+    /* Released together: earliest deadline first, the tie to priority */
+    setup(4, 2000);
+    tasks[0].deadline_ms = 1900;
+    tasks[1].deadline_ms = 800;
+    tasks[2].deadline_ms = 1200;
+    tasks[3].deadline_ms = 1200;
+    tasks[3].priority = 1;
+    run(1500);
+
+    CHECK(logged == 4);
+    CHECK(log_id[0] == 1);
+    CHECK(log_id[1] == 3);
+    CHECK(log_id[2] == 2);
+    CHECK(log_id[3] == 0);
+
+    for (i = 0; i < 4; i++)
+    {
+        CHECK(log_rslt[i] == LMT_OK);
+        CHECK(!log_late[i]);
+        CHECK(tasks[i].released == 1);
+        CHECK(tasks[i].done == 1);
+        CHECK(tasks[i].misses == 0);
+        CHECK(tasks[i].failed == 0);
+    }
+
+    return failures;
+}
+
+static uint32_t test_overload(void)
+{
+    uint32_t failures = 0;
+    uint32_t ambient_shed = 0;
+    uint32_t i;
+
+    /* 4 critical and 8 ambient sensors, about twice one counter's rate */
+    setup(TASKS, 1000);
+
+    for (i = 0; i < TASKS; i++)
+    {
+        tasks[i].priority = (i < 4) ? 1 : 0;
+        tasks[i].release_ms = (i * 397) % 1000;
+    }
+
+    run(60000);
+
+    CHECK(conserved(TASKS));
+
+    /* The critical sensors keep every reading */
+    for (i = 0; i < 4; i++)
+    {
+        CHECK(tasks[i].released >= 59);
+        CHECK(tasks[i].misses == 0);
+        CHECK(tasks[i].failed == 0);
+    }
+
+    /* The ambient ones lose readings, shed before they run */
+    for (i = 4; i < TASKS; i++)
+    {
+        CHECK(tasks[i].done < tasks[i].released);
+        CHECK(tasks[i].failed == 0);
+        ambient_shed += tasks[i].shed;
+    }
+
+    CHECK(ambient_shed > 0);
+
+    return failures;
+}
+
+static uint32_t test_shed(void)
+{
+    uint32_t failures = 0;
+
+    /* A deadline shorter than a reading: shed without running */
+    setup(1, 1000);
+    tasks[0].deadline_ms = 50;
+    run(5500);
+
+    CHECK(tasks[0].released == 6);
+    CHECK(tasks[0].shed == 6);
+    CHECK(tasks[0].misses == 6);
+    CHECK(tasks[0].done == 0);
+    CHECK(logged == 0);
+    CHECK(conserved(1));
+
+    /* Task 1's job waits behind task 0's reading past its next release,
+       which drops it for the new job */
+    setup(2, 1000);
+    tasks[0].deadline_ms = 500;
+    tasks[1].period_ms = 20;
+    tasks[1].deadline_ms = 1000;
+    run(1500);
+
+    CHECK(logged >= 2);
+    CHECK(log_id[0] == 0);
+    CHECK(tasks[0].done == 2);
+    CHECK(tasks[1].shed > 0);
+    CHECK(tasks[1].shed == tasks[1].misses);
+    CHECK(conserved(2));
+
+    return failures;
+}
+
+static uint32_t test_failed(void)
+{
+    uint32_t failures = 0;
+    uint32_t i, est;
+
+    /* Task 1's sensor is silent: its readings fail, in time */
+    setup(2, 1000);
+    sensors[1].pulses = 0;
+    est = tasks[1].est_ms;
+    run(3500);
+
+    CHECK(tasks[0].done == 4);
+    CHECK(tasks[1].released == 4);
+    CHECK(tasks[1].failed == 4);
+    CHECK(tasks[1].done == 0);
+    CHECK(tasks[1].misses == 0);
+    CHECK(tasks[1].est_ms == est);
+    CHECK(conserved(2));
+
+    for (i = 0; i < logged && i < LOG; i++)
+        CHECK((log_rslt[i] == LMT_OK) == (log_id[i] == 0));
+
+    return failures;
+}
+
+static const struct
+{
+    const char *name;
+    test_fptr_t fn;
+} tests[] = {
+    { "edf_order",                 test_edf_order },
+    { "overload",                  test_overload },
+    { "shed",                      test_shed },
+    { "failed",                    test_failed },
+};
+
+int main(void)
+{
+    uint32_t i, failed = 0, n;
+
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+    {
+        n = tests[i].fn();
+        printf("%-28s %s\n", tests[i].name, n ? "FAILED" : "ok");
+
+        if (n != 0)
+            failed++;
+    }
+
+    return (failed != 0) ? 1 : 0;
+}
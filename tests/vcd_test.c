@@ -0,0 +1,189 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * 
+ * File        vcd_test.c
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file vcd_test.c
+ * @brief VCD decoder tests on a small capture fixture, tests/data/bursts.vcd:
+ *        a burst cut off by the start of the capture, a burst with one
+ *        ringing edge, a clean burst and a burst cut off by the end. The
+ *        fixture path is the first argument.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "lmt01.h"
+#include "lmt01_vcd.h"
+
+#define CHECK(cond)                                                     \
+    do                                                                  \
+    {                                                                   \
+        if (!(cond))                                                    \
+        {                                                               \
+            printf("    %s:%d: %s\n", __FILE__, __LINE__, #cond);       \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+typedef uint32_t (*test_fptr_t)(void);
+
+static const char *fixture;
+
+/* Decode the fixture, the CSV lines into csv */
+static lmt_status_t decode(lmt_vcd_opts_t *opts, lmt_vcd_stats_t *stats,
+                           char *csv, size_t csv_len)
+{
+    FILE *in = fopen(fixture, "rb");
+    lmt_status_t rslt;
+    size_t n = 0;
+
+    if (in == NULL)
+        return LMT_E_DEV_NOT_FOUND;
+
+    opts->out = tmpfile();
+    rslt = lmt_vcd_decode(in, opts, stats);
+    fclose(in);
+
+    if (opts->out != NULL)
+    {
+        rewind(opts->out);
+        n = fread(csv, 1, csv_len - 1, opts->out);
+        fclose(opts->out);
+        opts->out = NULL;
+    }
+
+    csv[n] = '\0';
+
+    return rslt;
+}
+
+/* Complete bursts are reported, the cut-off ones and the ringing not */
+static uint32_t test_fixture(void)
+{
+    uint32_t failures = 0;
+    lmt_vcd_opts_t opts = {0};
+    lmt_vcd_stats_t stats;
+    char csv[256], want[256];
+
+    opts.signal = "lmt01";
+    opts.min_interval_ns = 8000;
+    opts.conv = CONV_TYPE_LUT;
+
+    CHECK(decode(&opts, &stats, csv, sizeof(csv)) == LMT_OK);
+
+    snprintf(want, sizeof(want), "0.005048000000,5,%.3f\n0.010036000000,4,%.3f\n",
+             lmt_pulses_to_temperature(5, CONV_TYPE_LUT),
+             lmt_pulses_to_temperature(4, CONV_TYPE_LUT));
+    CHECK(strcmp(csv, want) == 0);
+
+    CHECK(stats.readings == 2);
+    CHECK(stats.partial == 2);
+    CHECK(stats.edges == 15);
+    CHECK(stats.glitches == 1);
+    CHECK(stats.end_ps == 20500ULL * 1000000);
+
+    return failures;
+}
+
+/* Without the filter the ringing edge is a pulse */
+static uint32_t test_no_deglitch(void)
+{
+    uint32_t failures = 0;
+    lmt_vcd_opts_t opts = {0};
+    lmt_vcd_stats_t stats;
+    char csv[256];
+
+    opts.signal = "lmt01";
+    opts.conv = CONV_TYPE_EQU;
+
+    CHECK(decode(&opts, &stats, csv, sizeof(csv)) == LMT_OK);
+    CHECK(strncmp(csv, "0.005048000000,6,", 17) == 0);
+    CHECK(stats.readings == 2);
+    CHECK(stats.edges == 16);
+    CHECK(stats.glitches == 0);
+
+    return failures;
+}
+
+/* The signal is looked up by name, or is the first 1-bit variable */
+static uint32_t test_signal_select(void)
+{
+    uint32_t failures = 0;
+    lmt_vcd_opts_t opts = {0};
+    lmt_vcd_stats_t stats;
+    char csv[256];
+
+    opts.signal = "missing";
+    CHECK(decode(&opts, &stats, csv, sizeof(csv)) == LMT_E_DEV_NOT_FOUND);
+
+    /* clk: one rise near the end of the capture, so cut off */
+    opts.signal = NULL;
+    CHECK(decode(&opts, &stats, csv, sizeof(csv)) == LMT_OK);
+    CHECK(csv[0] == '\0');
+    CHECK(stats.readings == 0);
+    CHECK(stats.partial == 1);
+    CHECK(stats.edges == 1);
+
+    CHECK(lmt_vcd_decode(NULL, &opts, &stats) == LMT_E_NULL_PTR);
+
+    return failures;
+}
+
+static const struct
+{
+    const char *name;
+    test_fptr_t fn;
+} tests[] = {
+    { "fixture",                   test_fixture },
+    { "no_deglitch",               test_no_deglitch },
+    { "signal_select",             test_signal_select },
+};
+
+int main(int argc, char **argv)
+{
+    uint32_t i, failed = 0, n;
+
+    if (argc < 2)
+    {
+        printf("usage: %s bursts.vcd\n", argv[0]);
+        return 2;
+    }
+
+    fixture = argv[1];
+
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+    {
+        n = tests[i].fn();
+        printf("%-28s %s\n", tests[i].name, n ? "FAILED" : "ok");
+
+        if (n != 0)
+            failed++;
+    }
+
+    return (failed != 0) ? 1 : 0;
+}
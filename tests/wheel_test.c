@@ -0,0 +1,317 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * 
+ * File        wheel_test.c
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file wheel_test.c
+ * @brief Timing wheel tests: insert, cancel, cascade through every level,
+ *        expiry order and tick wrap.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "lmt01_wheel.h"
+
+#define CHECK(cond)                                                     \
+    do                                                                  \
+    {                                                                   \
+        if (!(cond))                                                    \
+        {                                                               \
+            printf("    %s:%d: %s\n", __FILE__, __LINE__, #cond);       \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+#define ENTRIES     1000
+
+typedef uint32_t (*test_fptr_t)(void);
+
+static lmt_wheel_t wheel;
+static lmt_wheel_entry_t entries[ENTRIES];
+
+/* Expiries seen: entry index and the tick it fired on */
+static uint32_t fired;
+static uint32_t fired_id[ENTRIES * 4];
+static uint32_t fired_at[ENTRIES * 4];
+
+/* Period to re-add an entry with, 0 for one-shot */
+static uint32_t repeat_ms;
+
+static void on_expiry(lmt_wheel_entry_t *entry)
+{
+    if (fired < ENTRIES * 4)
+    {
+        fired_id[fired] = (uint32_t)(entry - entries);
+        fired_at[fired] = wheel.now;
+    }
+
+    fired++;
+
+    if (repeat_ms != 0)
+        lmt_wheel_add(&wheel, entry, repeat_ms);
+}
+
+/* Empty wheel at now_ms, n fresh entries */
+static void setup(uint32_t now_ms, uint32_t n)
+{
+    uint32_t i;
+
+    lmt_wheel_init(&wheel, now_ms);
+    fired = 0;
+    repeat_ms = 0;
+
+    for (i = 0; i < n; i++)
+    {
+        entries[i] = (lmt_wheel_entry_t){0};
+        entries[i].cb = on_expiry;
+    }
+}
+
+/* Run the wheel the way a sleeping caller would, up to end_ms. Nothing
+   may be due before the time lmt_wheel_next reported. */
+static uint32_t run_until(uint32_t end_ms)
+{
+    uint32_t failures = 0;
+    uint32_t next, before;
+
+    while ((int32_t)(end_ms - wheel.now) > 0 && (next = lmt_wheel_next(&wheel)) != UINT32_MAX)
+    {
+        if ((int32_t)(wheel.now + next - end_ms) > 0)
+            next = end_ms - wheel.now;
+
+        before = fired;
+        CHECK(next != 0);
+
+        if (next > 1)
+            CHECK(lmt_wheel_advance(&wheel, wheel.now + next - 1) == 0 && fired == before);
+
+        lmt_wheel_advance(&wheel, wheel.now + 1);
+    }
+
+    return failures;
+}
+
+/* Entries fire on their tick, in tick order */
+static uint32_t test_insert_order(void)
+{
+    static const uint32_t delays[] = { 5, 1, 3, 3, 0, 63, 64 };
+    uint32_t failures = 0;
+    uint32_t i;
+
+    setup(0, 7);
+
+    for (i = 0; i < 7; i++)
+        CHECK(lmt_wheel_add(&wheel, &entries[i], delays[i]) == LMT_OK);
+
+    CHECK(wheel.count == 7);
+    CHECK(lmt_wheel_next(&wheel) == 1);
+    CHECK(lmt_wheel_advance(&wheel, 100) == 7);
+    CHECK(wheel.count == 0);
+    CHECK(fired == 7);
+
+    /* A delay of 0 means the next tick */
+    CHECK((fired_id[0] == 1 || fired_id[0] == 4) && fired_at[0] == 1);
+    CHECK((fired_id[1] == 1 || fired_id[1] == 4) && fired_at[1] == 1);
+    CHECK((fired_id[2] == 2 || fired_id[2] == 3) && fired_at[2] == 3);
+    CHECK((fired_id[3] == 2 || fired_id[3] == 3) && fired_at[3] == 3);
+    CHECK(fired_id[4] == 0 && fired_at[4] == 5);
+    CHECK(fired_id[5] == 5 && fired_at[5] == 63);
+    CHECK(fired_id[6] == 6 && fired_at[6] == 64);
+    CHECK(lmt_wheel_next(&wheel) == UINT32_MAX);
+
+    /* A re-added entry fires every period */
+    setup(0, 1);
+    repeat_ms = 7;
+    lmt_wheel_add(&wheel, &entries[0], 7);
+    lmt_wheel_advance(&wheel, 70);
+    CHECK(fired == 10 && fired_at[9] == 70);
+    CHECK(wheel.count == 1);
+
+    return failures;
+}
+
+/* Cancelled or re-added entries do not fire at their old expiry */
+static uint32_t test_cancel(void)
+{
+    uint32_t failures = 0;
+
+    setup(0, 3);
+    lmt_wheel_add(&wheel, &entries[0], 10);
+    lmt_wheel_add(&wheel, &entries[1], 10);
+    lmt_wheel_add(&wheel, &entries[2], 5000);
+
+    lmt_wheel_cancel(&wheel, &entries[0]);
+    lmt_wheel_cancel(&wheel, &entries[0]);
+    lmt_wheel_cancel(&wheel, &entries[2]);
+    CHECK(wheel.count == 1);
+    CHECK(entries[0].prev == NULL);
+
+    /* Re-adding moves it */
+    lmt_wheel_add(&wheel, &entries[1], 20);
+    CHECK(wheel.count == 1);
+
+    CHECK(lmt_wheel_advance(&wheel, 19) == 0);
+    CHECK(lmt_wheel_advance(&wheel, 10000) == 1);
+    CHECK(fired == 1 && fired_id[0] == 1 && fired_at[0] == 20);
+
+    /* Bad input */
+    CHECK(lmt_wheel_add(NULL, &entries[0], 1) == LMT_E_NULL_PTR);
+    CHECK(lmt_wheel_add(&wheel, &entries[0], LMT_WHEEL_MAX_MS + 1) == LMT_E_INVALID);
+    CHECK(wheel.count == 0);
+
+    return failures;
+}
+
+/* Delays on every level are cascaded down and fire on their tick, both
+   tick by tick and when the wheel jumps */
+static uint32_t test_cascade(void)
+{
+    static const uint32_t delays[] = {
+        LMT_WHEEL_SLOTS - 1, LMT_WHEEL_SLOTS, LMT_WHEEL_SLOTS + 1,
+        LMT_WHEEL_SLOTS * LMT_WHEEL_SLOTS + 5,
+        LMT_WHEEL_SLOTS * LMT_WHEEL_SLOTS * LMT_WHEEL_SLOTS + 7,
+        LMT_WHEEL_MAX_MS
+    };
+    uint32_t failures = 0;
+    uint32_t i, jump;
+
+    for (jump = 0; jump < 2; jump++)
+    {
+        /* Start mid-turn on every level */
+        setup(12345, 6);
+
+        for (i = 0; i < 6; i++)
+            lmt_wheel_add(&wheel, &entries[i], delays[i]);
+
+        if (jump)
+            CHECK(lmt_wheel_advance(&wheel, 12345 + LMT_WHEEL_MAX_MS) == 6);
+        else
+            failures += run_until(12345 + LMT_WHEEL_MAX_MS);
+
+        CHECK(fired == 6);
+
+        for (i = 0; i < 6 && i < fired; i++)
+        {
+            CHECK(fired_id[i] == i);
+            CHECK(fired_at[i] == 12345 + delays[i]);
+        }
+    }
+
+    return failures;
+}
+
+/* The tick wraps through 0 */
+static uint32_t test_wrap(void)
+{
+    static const uint32_t delays[] = { 5, 10, 11, 100, 70000 };
+    uint32_t failures = 0;
+    uint32_t i;
+
+    setup(UINT32_MAX - 10, 5);
+
+    for (i = 0; i < 5; i++)
+        lmt_wheel_add(&wheel, &entries[i], delays[i]);
+
+    failures += run_until(UINT32_MAX - 10 + 70001);
+    CHECK(fired == 5);
+
+    for (i = 0; i < 5 && i < fired; i++)
+    {
+        CHECK(fired_id[i] == i);
+        CHECK(fired_at[i] == UINT32_MAX - 10 + delays[i]);
+    }
+
+    return failures;
+}
+
+/* Many random entries: each fires once, on its tick, in tick order */
+static uint32_t test_random(void)
+{
+    uint32_t failures = 0;
+    uint32_t expiry[ENTRIES];
+    uint8_t seen[ENTRIES] = {0};
+    uint32_t i, end = 0;
+
+    srand(7);
+    setup(1000, ENTRIES);
+
+    for (i = 0; i < ENTRIES; i++)
+    {
+        lmt_wheel_add(&wheel, &entries[i], (uint32_t)rand() % (1u << 20));
+        expiry[i] = entries[i].expiry;
+
+        if (expiry[i] > end)
+            end = expiry[i];
+    }
+
+    /* Random jumps */
+    while (wheel.now < end)
+        lmt_wheel_advance(&wheel, wheel.now + 1 + (uint32_t)rand() % 5000);
+
+    CHECK(fired == ENTRIES);
+
+    for (i = 0; i < fired && i < ENTRIES; i++)
+    {
+        CHECK(!seen[fired_id[i]]);
+        seen[fired_id[i]] = 1;
+        CHECK(fired_at[i] == expiry[fired_id[i]]);
+
+        if (i != 0)
+            CHECK(fired_at[i] >= fired_at[i - 1]);
+    }
+
+    return failures;
+}
+
+static const struct
+{
+    const char *name;
+    test_fptr_t fn;
+} tests[] = {
+    { "insert_order",              test_insert_order },
+    { "cancel",                    test_cancel },
+    { "cascade",                   test_cascade },
+    { "wrap",                      test_wrap },
+    { "random",                    test_random },
+};
+
+int main(void)
+{
+    uint32_t i, failed = 0, n;
+
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+    {
+        n = tests[i].fn();
+        printf("%-28s %s\n", tests[i].name, n ? "FAILED" : "ok");
+
+        if (n != 0)
+            failed++;
+    }
+
+    return (failed != 0) ? 1 : 0;
+}